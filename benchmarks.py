@@ -19,6 +19,14 @@ QUEUES_HASH = {
     "BMTQ"      : "BoundedMTQueue",
     "BMTQueue" : "BoundedMTQueue",
     "BoundedMTQueue": "BoundedMTQueue",
+    "BoundedMTQueue/nobackoff": "BoundedMTQueue/nobackoff",
+    "BoundedMTQueue/jitter": "BoundedMTQueue/jitter",
+    "BoundedMTQueue/yield": "BoundedMTQueue/yield",
+    "LMTQ"      : "LinkedMTQueue",
+    "LinkedMTQueue": "LinkedMTQueue",
+    "LinkedMTQueue/nobackoff": "LinkedMTQueue/nobackoff",
+    "LinkedMTQueue/jitter": "LinkedMTQueue/jitter",
+    "LinkedMTQueue/yield": "LinkedMTQueue/yield",
     "LinkedCRQ" : "LinkedCRQueue",
     "LCRQ"      : "LinkedCRQueue",
     "LinkedPRQ" : "LinkedPRQueue",
@@ -38,10 +46,58 @@ QUEUES_HASH = {
     "BoundedMuxQueue": "BoundedMuxQueue",
     "FAAQueue"  : "FAAQueue",
     "FAAQ"      : "FAAQueue",
-    "FAA"       : "FAAQueue"
+    "FAA"       : "FAAQueue",
+    "BoundedSPSC": "BoundedSPSCQueue",
+    "BSPSC"     : "BoundedSPSCQueue",
+    "BoundedSPSCQueue": "BoundedSPSCQueue",
+    "LinkedSPSC": "LinkedSPSCQueue",
+    "LSPSC"     : "LinkedSPSCQueue",
+    "LinkedSPSCQueue": "LinkedSPSCQueue",
+    "MPSC"      : "MPSCQueue",
+    "MPSCQueue" : "MPSCQueue",
+    "LinkedMPSC": "LinkedMPSCQueue",
+    "LMPSC"     : "LinkedMPSCQueue",
+    "LinkedMPSCQueue": "LinkedMPSCQueue",
+    "LinkedSCQ" : "LinkedSCQueue",
+    "LSCQ"      : "LinkedSCQueue",
+    "LinkedSCQueue": "LinkedSCQueue",
+    "WFQ"       : "WFQueue",
+    "WFQueue"   : "WFQueue",
+    "ShardedLCRQ": "ShardedLinkedCRQueue",
+    "ShardedLinkedCRQueue": "ShardedLinkedCRQueue",
+    "ShardedLPRQ": "ShardedLinkedPRQueue",
+    "ShardedLinkedPRQueue": "ShardedLinkedPRQueue",
+    "NumaLCRQ"  : "NumaLinkedCRQueue",
+    "NumaLinkedCRQueue": "NumaLinkedCRQueue",
+    "NumaLPRQ"  : "NumaLinkedPRQueue",
+    "NumaLinkedPRQueue": "NumaLinkedPRQueue",
+    "LinkedCRQueue/remapped": "LinkedCRQueue/remapped",
+    "LinkedPRQueue/remapped": "LinkedPRQueue/remapped",
+    "LinkedMTQueue/remapped": "LinkedMTQueue/remapped",
+    "FAAQueue/remapped": "FAAQueue/remapped",
+    "BoundedCRQueue/remapped": "BoundedCRQueue/remapped",
+    "BoundedPRQueue/remapped": "BoundedPRQueue/remapped",
+    "BoundedMTQueue/remapped": "BoundedMTQueue/remapped",
+    "LCompactCRQ": "LinkedCompactCRQueue",
+    "LinkedCompactCRQueue": "LinkedCompactCRQueue",
+    "BCompactCRQ": "BoundedCompactCRQueue",
+    "BoundedCompactCRQueue": "BoundedCompactCRQueue",
+    "LinkedCRQueue/fixed4096": "LinkedCRQueue/fixed4096",
+    "LinkedPRQueue/fixed4096": "LinkedPRQueue/fixed4096",
+    "LinkedMTQueue/fixed4096": "LinkedMTQueue/fixed4096",
+    "BoundedCRQueue/fixed4096": "BoundedCRQueue/fixed4096",
+    "BoundedPRQueue/fixed4096": "BoundedPRQueue/fixed4096",
+    "BoundedMTQueue/fixed4096": "BoundedMTQueue/fixed4096"
 }
-BOUNDED     : set = {"BoundedCRQueue", "BoundedPRQueue", "BoundedMuxQueue","BoundedMTQueue"}
-UNBOUNDED   : set = {"LinkedCRQueue", "LinkedPRQueue", "LinkedMuxQueue", "FAAQueue"}
+BOUNDED     : set = {"BoundedCRQueue", "BoundedPRQueue", "BoundedMuxQueue","BoundedMTQueue","BoundedSPSCQueue",
+               "BoundedMTQueue/nobackoff","BoundedMTQueue/jitter","BoundedMTQueue/yield",
+               "BoundedCRQueue/remapped","BoundedPRQueue/remapped","BoundedMTQueue/remapped","BoundedCompactCRQueue",
+               "BoundedCRQueue/fixed4096","BoundedPRQueue/fixed4096","BoundedMTQueue/fixed4096"}
+UNBOUNDED   : set = {"LinkedCRQueue", "LinkedPRQueue", "LinkedSCQueue", "LinkedMuxQueue", "FAAQueue","LinkedSPSCQueue","MPSCQueue","LinkedMPSCQueue","WFQueue",
+               "ShardedLinkedCRQueue","ShardedLinkedPRQueue","NumaLinkedCRQueue","NumaLinkedPRQueue",
+               "LinkedMTQueue","LinkedMTQueue/nobackoff","LinkedMTQueue/jitter","LinkedMTQueue/yield",
+               "LinkedCRQueue/remapped","LinkedPRQueue/remapped","LinkedMTQueue/remapped","FAAQueue/remapped","LinkedCompactCRQueue",
+               "LinkedCRQueue/fixed4096","LinkedPRQueue/fixed4096","LinkedMTQueue/fixed4096"}
 QUEUES      : set = BOUNDED.union(UNBOUNDED)
 
 def parseQueues(data):
@@ -65,6 +121,7 @@ def parseQueues(data):
 """Utilities for flag parsing"""
 
 BENCH_FLAGS = ["output","progress","overwrite"]
+CLUSTER_MODES = ["Off","Cohort"]    # ClusterMode of the ring segments (runtime, no rebuild)
 
 def parseFlags(data):
     if type(data) is str: data = list(data)
@@ -136,7 +193,7 @@ BENCH_ID            = {"EnqueueDequeue", "ProdCons", "Pairs", "Memory"}
 REQUIRED            = {"benchmark","path","threads","runs","iterations","queues"}
 REQUIRED_PROD_CONS  = {"threads","producers","consumers"} #if thread not set
 REQUIRED_MEM        = {"benchmark","path","producers","consumers","queues","duration_sec","granularity_msec"}
-OPTIONAL            = {"warmup","additionalWork","flags","sizes","ratio"}
+OPTIONAL            = {"warmup","additionalWork","flags","sizes","ratio","cluster"}
 #union to optional
 OPTIONAL_MEM        = {"memoryArgs"}
 OPTIONAL_PROD_CONS  = {"balanced"}
@@ -156,6 +213,7 @@ OPTIONAL_PROD_CONS  = {"balanced"}
     additionalWork: float, list float | nullable [set 0]
     size    : int, list int | nullable
     flags   : subset{"output","progress","overwrite"} str | list str
+    cluster : "Off" | "Cohort" | nullable [Off]
     memoryArgs : dict #if MemoryBenchmark
 }
 
@@ -252,6 +310,9 @@ def parseBenchmark(benchmark:dict) -> list :
                     benchmark[key] = DELIM.join(list(map(str,benchmark[key])))
                 case "flags":
                     benchmark[key] = parseFlags(benchmark[key])
+                case "cluster":
+                    if benchmark[key] not in CLUSTER_MODES:
+                        strerror(f"Invalid {key} value: {benchmark[key]} | Must be one of {CLUSTER_MODES}")
                 case "memoryArgs":
                     benchmark[key] = parseMemoryFlags(benchmark[key])
                 case "warmup" | "sizes":
@@ -324,6 +385,7 @@ if __name__ == "__main__":
         benchConf.add_argument  ("-w","--warmup",help="Warmup iterations",type=int,nargs="+",default=None,metavar="")
         benchConf.add_argument  ("-a","--additionalWork",help="Work done between operations",type=float,nargs="+",default=None,metavar='')
         queueOpt.add_argument   ("-p","--disable_padding",help="disable padding for queues",action="store_true")
+        queueOpt.add_argument   ("-c","--cluster",help="cluster mode of the segments [Off, Cohort]",type=str,default=None,metavar="")
     args = parser.parse_args()
 
     #make a dictionary
@@ -341,7 +403,8 @@ if __name__ == "__main__":
             "sizes":args.size,
             "warmup":args.warmup,
             "additionalWork":args.additionalWork,
-            "padding":args.disable_padding
+            "padding":args.disable_padding,
+            "cluster":args.cluster
         }
         
         r,i = "runs","iterations" if args.benchmark != "Memory" else "duration_sec","granularity_msec"
@@ -8,6 +8,7 @@
 #include <vector>
 #include <unordered_map>
 #include "Stats.hpp"
+#include "ClusterPolicy.hpp"
 #include <type_traits>
 #include <iomanip>
 
@@ -32,9 +33,10 @@ struct Arguments {
     bool _stdout            = true;
     bool _progress          = true;
     bool _overwrite         = false;
+    ClusterMode _cluster    = ClusterMode::Off;    //cluster mode of the segments (set by the benchmark constructor)
 
-    Arguments(bool f_stdout,bool f_progress,bool f_overwrite):
-    _stdout(f_stdout),_progress(f_progress),_overwrite(f_overwrite)
+    Arguments(bool f_stdout,bool f_progress,bool f_overwrite,ClusterMode cluster = ClusterMode::Off):
+    _stdout(f_stdout),_progress(f_progress),_overwrite(f_overwrite),_cluster(cluster)
     {}
     Arguments(){};
     ~Arguments(){};
@@ -62,6 +64,12 @@ struct UserData {
 
 };
 
+//Trivially copyable payload of the payload benchmarks: storable in the cells of the inline queues
+struct Message {
+    uint32_t producer = 0;
+    uint32_t seq      = 0;
+};
+
 /**
  * Memory Arguments that can be given in order control the 
  * behaviour of threads like:
@@ -104,6 +112,42 @@ static inline void printBenchmarkResults(string title, string resultLabel, const
     cout << string(boxWidth, '#') << endl;
 }
 
+//one label / value line of the result box (digits grouped by formatDigits)
+static inline void printStat(const string& label, uint64_t value) {
+    cout << left << setw(20) << label << right << setw(20) << formatDigits(value) << "\n";
+}
+
+//one label / value line of the result box (fractional value)
+static inline void printStat(const string& label, long double value, int precision) {
+    cout << left << setw(20) << label << right << setw(20) << fixed << setprecision(precision) << value << "\n";
+}
+
+/*
+    Prints the reclamation statistics (hazard pointer scans, epoch advances) collected
+    by the queues that expose getReclaimStats()
+*/
+template<typename R>
+static inline void printReclaimStats(const R& reclaim) {
+    if(reclaim.scans == 0) return;
+    printStat("Reclaim scans",reclaim.scans);
+    printStat("Avg scan (ns)",reclaim.scanNs / reclaim.scans);
+    printStat("Reclaimed",reclaim.reclaimed);
+    cout << string(40, '#') << endl;
+}
+
+/*
+    Prints the slow path pushes and the forced closes of the queues that
+    expose getPushStats() (CRQ / PRQ segments, see StarvingPush)
+*/
+template<typename P>
+static inline void printPushStats(const P& push) {
+    if(push.slowPushes == 0 && push.forcedCloses == 0) return;
+    printStat("Slow pushes",push.slowPushes);
+    printStat("Helped pushes",push.helpedPushes);
+    printStat("Forced closes",push.forcedCloses);
+    cout << string(40, '#') << endl;
+}
+
 private: 
 uint32_t __GCD(size_t a, size_t b){
     return (b==0)? a : __GCD(b,a % b);
@@ -116,7 +160,7 @@ uint32_t GCD(size_t a, size_t b){
 protected:
 static void ThroughputCSVHeader(std::ostream& stream){
     stream  << "Benchmark,QueueType,Threads,AdditionalWork,RingSize,"
-            << "Duration,Iterations,Score,ScoreError" << endl;
+            << "Duration,Iterations,Score,ScoreError,Cluster" << endl;
 } 
 static void ThroughputCSVData( std::ostream& stream,
                         std::string_view benchmark,
@@ -130,7 +174,8 @@ static void ThroughputCSVData( std::ostream& stream,
 {
     stream  << benchmark << "," << queueType << "," << threads << "," << additionalWork
             << "," << ring_size << "," << duration << "," << iterations << "," <<
-            static_cast<uint64_t>(stats.mean) << "," << static_cast<long double>(stats.stddev) << endl;  
+            static_cast<uint64_t>(stats.mean) << "," << static_cast<long double>(stats.stddev) << "," <<
+            clusterModeName(getClusterMode()) << endl;  
 }
 
 // Assuming Q<UserData>::className() returns a string and sts.mean and sts.stddev are numeric types
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <barrier>
+#include <thread>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+#include "Benchmark.hpp"        //  for benchmarking Base Class
+#include "ThreadGroup.hpp"      //  for thread management
+#include "Stats.hpp"            //  for average and stddev computation
+#include "AdditionalWork.hpp"   //  Additional Work by threads
+#include "QueueTypeSet.hpp"
+
+namespace bench {
+
+/*
+    Per-operation latency of producers and consumers (e.g. 1:K load):
+    every push and every pop is timed on its own, so the tail of the
+    distribution (p99.99, max) shows the operations that retry for long,
+    which the throughput benchmarks average away.
+
+    Every thread keeps up to `samples` latencies per run (later operations
+    are executed but not recorded); the samples of all the threads and runs
+    are merged before computing the percentiles.
+
+    The producers of the unbounded queues check length() (a walk of the
+    segments) once every `lengthCheck` pushes, outside the timed region: while
+    the queue is over ringSize * 16 items the pushes are skipped, and skipped
+    pushes are neither timed nor counted.
+*/
+class LatencyBenchmark: public Benchmark {
+public:
+    //latency distribution of one operation (nanoseconds)
+    struct Percentiles {
+        uint64_t p50 = 0, p99 = 0, p999 = 0, p9999 = 0, max = 0;
+        size_t count = 0;
+    };
+
+    Arguments flags;
+    size_t producers, consumers;
+    size_t ringSize;
+    double additionalWork;
+    size_t samples;                 //latencies recorded per thread and run
+    Percentiles pushLatency, popLatency;
+    long double transfersPerSec = 0;
+
+    LatencyBenchmark(size_t prodCount,
+                     size_t consCount,
+                     double additionalWork_par = 0.0,
+                     size_t ringSz = RINGSIZE,
+                     size_t samples_par = 1'000'000,
+                     Arguments flags = Arguments()):
+    flags{flags}, producers{prodCount}, consumers{consCount}, ringSize{ringSz},
+    additionalWork{additionalWork_par}, samples{samples_par} {
+        if(producers == 0 || consumers == 0)    throw invalid_argument("Threads count must be greater than 0");
+        if(ringSize == 0)                       throw invalid_argument("Ring Size must be greater than 0");
+        if(additionalWork < 0)                  throw invalid_argument("Additional Work must be greater than 0");
+        if(samples == 0)                        throw invalid_argument("Samples must be greater than 0");
+        setClusterMode(flags._cluster);
+    }
+
+    string toString() const {
+        return "latency[" + to_string(producers) + "/" + to_string(consumers) + "]";
+    }
+
+    template<template<typename> typename Q>
+    void run(const seconds runDuration, const size_t numRuns, const std::string fileName = ""){
+        __Latency<Q>(runDuration,numRuns);
+        const string name = Q<UserData>::className();
+
+        if(flags._stdout)
+            printLatency(name);
+
+        if(fileName != ""){
+            bool header = flags._overwrite || !fileExists(fileName);
+            ofstream csv(fileName, header? ios::trunc : ios::app);
+            if(header) LatencyCSVHeader(csv);
+            LatencyCSVData(csv,name,runDuration.count(),numRuns);
+            csv.close();
+        }
+    }
+
+private:
+    static Percentiles percentiles(vector<uint32_t>& lat){
+        Percentiles p{};
+        p.count = lat.size();
+        if(lat.empty()) return p;
+        std::sort(lat.begin(),lat.end());
+        auto at = [&lat](double q){ return static_cast<uint64_t>(lat[static_cast<size_t>(q * (lat.size() - 1))]); };
+        p.p50   = at(0.5);
+        p.p99   = at(0.99);
+        p.p999  = at(0.999);
+        p.p9999 = at(0.9999);
+        p.max   = lat.back();
+        return p;
+    }
+
+    void printLatency(const string& name) const {
+        printBenchmarkResults(name,"Transf/Sec",transfersPerSec,0.0L);
+        for(auto [op,p] : {pair{"push",pushLatency},pair{"pop",popLatency}}){
+            const string o = op;
+            printStat(o + " p50 (ns)",p.p50);
+            printStat(o + " p99 (ns)",p.p99);
+            printStat(o + " p99.9 (ns)",p.p999);
+            printStat(o + " p99.99 (ns)",p.p9999);
+            printStat(o + " max (ns)",p.max);
+        }
+        cout << string(40, '#') << endl;
+    }
+
+    template<template<typename> typename Q>
+    void __Latency(const seconds runDuration, const size_t numRuns){
+        using namespace std;
+        using namespace chrono;
+        using Queue = Q<UserData>;
+
+        if(SPSCQueues::Contains<Q> && (producers != 1 || consumers != 1))
+            throw invalid_argument(Queue::className() + " supports a single producer and a single consumer");
+        if(MPSCQueues::Contains<Q> && consumers != 1)
+            throw invalid_argument(Queue::className() + " supports a single consumer");
+        bool constexpr bounded = BoundedQueues::Contains<Q>;
+        size_t constexpr lengthCheck = 64;  //pushes of the unbounded queues between two length() checks
+
+        const size_t threads = producers + consumers;
+        vector<vector<uint32_t>> pushLat(producers), popLat(consumers);
+        vector<uint64_t> transferred(consumers);
+        Queue* queue = nullptr;
+        atomic<bool> stopFlag{false};
+        barrier<> barrier(threads + 1);
+
+        //records the latency of an operation, returns its result
+        const auto timed = [this](vector<uint32_t>& lat, auto&& op){
+            const auto start = steady_clock::now();
+            auto res = op();
+            const auto ns = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+            if(lat.size() < samples)
+                lat.push_back(static_cast<uint32_t>(std::min<int64_t>(ns,UINT32_MAX)));
+            return res;
+        };
+
+        const auto prod_lambda = [this,&queue,&stopFlag,&barrier,&pushLat,&timed](const int tid){
+            UserData ud{};
+            vector<uint32_t>& lat = pushLat[tid];
+            size_t budget = 0;  //pushes left before the next length() check
+            barrier.arrive_and_wait();
+            while(!stopFlag.load()){
+                if constexpr (bounded){
+                    if(!timed(lat,[&]{ return queue->push(&ud,tid); }))
+                        std::this_thread::yield();  //full ring: leave room to the consumers
+                } else if constexpr (ConsumerLengthQueues::Contains<Q>){
+                    timed(lat,[&]{ queue->push(&ud,tid); return true; });
+                } else {
+                    //keeps the queue from growing without bound when consumers are slower
+                    if(budget == 0 && queue->length(tid) < ringSize * 16)
+                        budget = lengthCheck;
+                    if(budget > 0){
+                        --budget;
+                        timed(lat,[&]{ queue->push(&ud,tid); return true; });
+                    }
+                }
+                random_additional_work(additionalWork);
+            }
+        };
+
+        const auto cons_lambda = [this,&queue,&stopFlag,&barrier,&popLat,&transferred,&timed](const int tid){
+            vector<uint32_t>& lat = popLat[tid - producers];
+            uint64_t count = 0;
+            barrier.arrive_and_wait();
+            while(!stopFlag.load()){
+                if(timed(lat,[&]{ return queue->pop(tid); }) != nullptr)
+                    ++count;
+                random_additional_work(additionalWork);
+            }
+            transferred[tid - producers] += count;
+        };
+
+        vector<uint32_t> allPush, allPop;
+        nanoseconds elapsed{0};
+        for(size_t iRun = 0; iRun < numRuns; iRun++){
+            for(auto& l : pushLat) { l.clear(); l.reserve(samples); }
+            for(auto& l : popLat)  { l.clear(); l.reserve(samples); }
+            queue = new Queue(ringSize,threads);
+            stopFlag.store(false);
+
+            ThreadGroup threadSet{};
+            for(size_t i = 0; i < producers; i++)
+                threadSet.thread(prod_lambda);
+            for(size_t i = 0; i < consumers; i++)
+                threadSet.thread(cons_lambda);
+            barrier.arrive_and_wait();      //starts the run
+
+            auto startBeat = steady_clock::now();
+            std::this_thread::sleep_for(runDuration);
+            stopFlag.store(true);
+            elapsed += duration_cast<nanoseconds>(steady_clock::now() - startBeat);
+            threadSet.join();
+            delete queue;
+
+            for(auto& l : pushLat) allPush.insert(allPush.end(),l.begin(),l.end());
+            for(auto& l : popLat)  allPop.insert(allPop.end(),l.begin(),l.end());
+        }
+
+        uint64_t total = 0;
+        for(uint64_t t : transferred) total += t;
+        transfersPerSec = static_cast<long double>(total * NSEC_SEC) / std::max<int64_t>(elapsed.count(),1);
+        pushLatency = percentiles(allPush);
+        popLatency  = percentiles(allPop);
+    }
+
+    static void LatencyCSVHeader(std::ostream& stream){
+        stream  << "Benchmark,QueueType,Producers,Consumers,AdditionalWork,RingSize,Duration,Runs,Score,"
+                << "Operation,Samples,P50,P99,P999,P9999,Max,Cluster" << endl;
+    }
+
+    void LatencyCSVData(std::ostream& stream, std::string_view queueType, uint64_t duration, size_t numRuns) const {
+        for(auto [op,p] : {pair{"push",pushLatency},pair{"pop",popLatency}}){
+            stream  << toString() << "," << queueType << "," << producers << "," << consumers << ","
+                    << additionalWork << "," << ringSize << "," << duration << "," << numRuns << ","
+                    << static_cast<uint64_t>(transfersPerSec) << "," << op << "," << p.count << ","
+                    << p.p50 << "," << p.p99 << "," << p.p999 << "," << p.p9999 << "," << p.max << ","
+                    << clusterModeName(getClusterMode()) << endl;
+        }
+    }
+
+public:
+    /*
+        Runs one producer against every number of consumers in consumerSet (1:K load)
+    */
+    template<template<typename> typename Q>
+    static void runSeries  (const std::string csvFileName,
+                            const vector<size_t> consumerSet,
+                            const size_t ringSize,
+                            const seconds runDuration,
+                            const size_t numRuns,
+                            const Arguments args=Arguments())
+    {
+        bool header = args._overwrite || !fileExists(csvFileName);
+        ofstream csvFile(csvFileName,header? ios::trunc : ios::app);
+        if(header)
+            LatencyCSVHeader(csvFile);
+
+        int iTest = 0;
+        for(size_t nCons : consumerSet){
+            LatencyBenchmark bench(1,nCons,0.0,ringSize,1'000'000,args);
+            bench.__Latency<Q>(runDuration,numRuns);
+            bench.LatencyCSVData(csvFile,Q<UserData>::className(),runDuration.count(),numRuns);
+            iTest++;
+            if(args._progress)
+                cout << "Executed " << iTest << " of " << consumerSet.size() << " runs" << endl;
+            if(args._stdout)
+                bench.printLatency(Q<UserData>::className());
+        }
+    }
+};
+
+}
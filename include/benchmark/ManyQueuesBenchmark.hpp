@@ -0,0 +1,224 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <barrier>
+#include <memory>
+#include <iostream>
+#include <fstream>
+#include <cassert>
+#include <malloc.h>
+
+#include "Benchmark.hpp"        //  for benchmarking Base Class
+#include "ThreadGroup.hpp"      //  for thread management
+#include "Stats.hpp"            //  for average and stddev computation
+#include "AdditionalWork.hpp"   //  Additional Work by threads
+#include "QueueTypeSet.hpp"
+
+namespace bench {
+
+/*
+    Many queue instances (e.g. per-connection mailboxes) used by a few threads:
+    every iteration a thread pushes to and pops from a randomly chosen queue.
+
+    Compares queues with a private reclamation domain against queues attached
+    to one shared domain (Q::makeDomain): reports the throughput and the memory
+    (heap in use) taken by the queues at the end of the run.
+*/
+class ManyQueuesBenchmark: public Benchmark {
+public:
+    Arguments flags;
+    size_t threads;
+    size_t queues;
+    size_t ringSize;
+    double additionalWork;
+    bool sharedDomain;
+    ReclaimStats reclaimStats{};    //memory reclamation statistics over all runs
+    size_t heapKB = 0;              //max memory taken by the queues over all runs
+
+    ManyQueuesBenchmark(size_t threads_par,
+                        size_t queues_par,
+                        bool shared,
+                        double additionalWork_par = 0.0,
+                        size_t ringSz = RINGSIZE,
+                        Arguments flags = Arguments()):
+    flags{flags}, threads{threads_par}, queues{queues_par}, ringSize{ringSz},
+    additionalWork{additionalWork_par}, sharedDomain{shared} {
+        if(threads == 0)        throw invalid_argument("Threads must be greater than 0");
+        if(queues == 0)         throw invalid_argument("Queues must be greater than 0");
+        if(ringSize == 0)       throw invalid_argument("Ring Size must be greater than 0");
+        if(additionalWork < 0)  throw invalid_argument("Additional Work must be greater than 0");
+        setClusterMode(flags._cluster);
+    }
+
+    static string toString(){
+        return "ManyQueues";
+    }
+
+    template<template<typename> typename Q>
+    void run(const size_t IterNum, const size_t numRuns, const std::string fileName = ""){
+        auto res = __ManyQueuesBenchmark<Q>(IterNum,numRuns);
+        Stats<long double> sts = stats(res.begin(),res.end());
+        const string name = className<Q>();
+
+        if(flags._stdout){
+            printBenchmarkResults(name,"Ops/Sec",sts.mean,sts.stddev);
+            printHeap(heapKB);
+            printReclaimStats(reclaimStats);
+        }
+
+        if(fileName != ""){
+            bool header = flags._overwrite || !fileExists(fileName);
+            ofstream csv(fileName, header? ios::trunc : ios::app);
+            if(header) ManyQueuesCSVHeader(csv);
+            ManyQueuesCSVData(csv,name,IterNum,numRuns,sts);
+            csv.close();
+        }
+    }
+
+private:
+    template<template<typename> typename Q>
+    string className() const {
+        return Q<UserData>::className() + (sharedDomain? "/shared" : "");
+    }
+
+    static void printHeap(size_t kb){
+        printStat("Queues heap (KB)",kb);
+        cout << string(40, '#') << endl;
+    }
+
+    /*
+        heap memory in use (KB): unlike the RSS it goes down when memory is freed,
+        so the runs do not inherit the pages of the previous ones
+    */
+    static size_t heapInUse(){
+        struct mallinfo2 info = mallinfo2();
+        return (info.uordblks + info.hblkhd) / 1024;
+    }
+
+    template<template<typename> typename Q>
+    vector<long double> __ManyQueuesBenchmark(const size_t IterNum, const size_t numRuns){
+        using namespace std;
+        using namespace chrono;
+        using Queue = Q<UserData>;
+        static_assert(requires{ typename Queue::Domain; }, "ManyQueuesBenchmark: the queue has no reclamation domain");
+
+        nanoseconds deltas[threads][numRuns];
+        barrier<> barrier(threads + 1);
+        vector<unique_ptr<Queue>> instances;
+        const size_t IterPerThread = IterNum / threads;
+        assert(IterPerThread > 0);
+
+        //Threads Routine
+        const auto lambda = [this,IterPerThread,&instances,&barrier](const int tid) {
+            UserData ud{};
+            uint64_t seed = 0x9E3779B97F4A7C15ull * (tid + 1);    //xorshift: same sequence of queues every run
+            barrier.arrive_and_wait();
+
+            auto startBeat = steady_clock::now();
+            for(size_t iter = 0; iter < IterPerThread; ++iter){
+                seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+                Queue* queue = instances[seed % instances.size()].get();
+                queue->push(&ud,tid);
+                random_additional_work(additionalWork);
+                queue->pop(tid);
+            }
+            auto stopBeat = steady_clock::now();
+            return stopBeat - startBeat;
+        };
+
+        for(size_t iRun = 0; iRun < numRuns; iRun++){
+            const size_t heapStart = heapInUse();
+            shared_ptr<typename Queue::Domain> domain = sharedDomain? Queue::makeDomain(threads) : nullptr;
+            for(size_t iQueue = 0; iQueue < queues; iQueue++){
+                if(sharedDomain)
+                    instances.push_back(make_unique<Queue>(ringSize,domain));
+                else
+                    instances.push_back(make_unique<Queue>(ringSize,threads));
+            }
+
+            ThreadGroup threadSet{};
+            for(size_t iThread = 0; iThread < threads; ++iThread)
+                threadSet.threadWithResult(lambda,deltas[iThread][iRun]);
+            barrier.arrive_and_wait();      //starts the run
+            threadSet.join();
+
+            heapKB = max(heapKB,heapInUse() - heapStart);
+            if(sharedDomain)
+                reclaimStats += domain->getStats();
+            else{
+                for(auto& queue : instances)
+                    reclaimStats += queue->getReclaimStats();
+            }
+            instances.clear();
+        }
+
+        vector<long double> opsPerSec(numRuns);
+        for(size_t iRun = 0; iRun < numRuns; ++iRun){
+            auto agg = 0ns;
+            for(size_t iThread = 0; iThread < threads; ++iThread)
+                agg += deltas[iThread][iRun];
+            opsPerSec[iRun] = static_cast<long double>(IterNum * 2 * (NSEC_SEC) * threads) / agg.count();
+        }
+        return opsPerSec;
+    }
+
+    static void ManyQueuesCSVHeader(std::ostream& stream){
+        stream  << "Benchmark,QueueType,Threads,Queues,AdditionalWork,RingSize,"
+                << "Iterations,Runs,Score,ScoreError,HeapKB,Cluster" << endl;
+    }
+
+    void ManyQueuesCSVData(std::ostream& stream, std::string_view queueType, size_t iterations,
+                           size_t numRuns, const Stats<long double> stats) const {
+        stream  << toString() << "," << queueType << "," << threads << "," << queues << ","
+                << additionalWork << "," << ringSize << "," << iterations << "," << numRuns << ","
+                << static_cast<uint64_t>(stats.mean) << "," << static_cast<long double>(stats.stddev) << ","
+                << heapKB << "," << clusterModeName(getClusterMode()) << endl;
+    }
+
+public:
+    /*
+        Runs the same configuration with private and shared domains
+        for every number of threads / queues
+    */
+    template<template<typename> typename Q>
+    static void runSeries  (const std::string csvFileName,
+                            const vector<size_t> threadSet,
+                            const vector<size_t> queueSet,
+                            const size_t ringSize,
+                            const size_t IterNum,
+                            const size_t numRuns,
+                            const Arguments args=Arguments())
+    {
+        bool header = args._overwrite || !fileExists(csvFileName);
+        ofstream csvFile(csvFileName,header? ios::trunc : ios::app);
+        if(header)
+            ManyQueuesCSVHeader(csvFile);
+
+        const int totalTests = threadSet.size() * queueSet.size() * 2;
+        int iTest = 0;
+
+        for(size_t nThreads : threadSet){
+            for(size_t nQueues : queueSet){
+                for(bool shared : {false,true}){
+                    ManyQueuesBenchmark bench(nThreads,nQueues,shared,0.0,ringSize,args);
+                    std::vector<long double> result = bench.__ManyQueuesBenchmark<Q>(IterNum,numRuns);
+                    Stats<long double> sts = stats(result.begin(),result.end());
+                    bench.ManyQueuesCSVData(csvFile,bench.className<Q>(),IterNum,numRuns,sts);
+                    iTest++;
+                    if(args._progress)
+                        cout << "Executed " << iTest << " of " << totalTests << " runs" << endl;
+                    if(args._stdout){
+                        printBenchmarkResults(bench.className<Q>(),"Ops/Sec",sts.mean,sts.stddev);
+                        printHeap(bench.heapKB);
+                        printReclaimStats(bench.reclaimStats);
+                    }
+                }
+            }
+        }
+    }
+};
+
+}
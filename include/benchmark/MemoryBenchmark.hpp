@@ -8,6 +8,7 @@
 #include <sys/wait.h>
 #include <barrier>
 #include <functional>
+#include <algorithm>
 #include "Benchmark.hpp"
 #include "ThreadGroup.hpp"
 #include "AdditionalWork.hpp"
@@ -86,6 +87,10 @@ public:
     size_t min_memory{0};
     std::chrono::milliseconds maxReachSleep{0};
     std::chrono::milliseconds minReachSleep{0};
+    //stalled consumers: block inside a pop holding the reclamation protection
+    size_t stalledConsumers{0};
+    std::chrono::milliseconds stallTime{0};
+    std::chrono::milliseconds stallPeriod{0};
 
     MemoryControl(){}; //Default constructor
 
@@ -100,6 +105,10 @@ public:
                     std::chrono::milliseconds sleep,
                     std::chrono::milliseconds uptime
     );
+    void stall(     size_t consumers,
+                    std::chrono::milliseconds stallTime,
+                    std::chrono::milliseconds period
+    );
 
     friend class MemoryBenchmark;
 };
@@ -267,6 +276,32 @@ private:
                 }
             }
         };
+        /*
+            Stalled consumer: pops for stallPeriod then stops for stallTime in the middle
+            of a pop (the queue keeps the head protected), as a descheduled thread would do
+        */
+        const auto cons_stalled = [this,&stopFlag,&queue,&barrier](const int tid){
+            const auto stall = [this,&stopFlag](){
+                auto endtime = steady_clock::now() + memoryFlags.stallTime;
+                while(steady_clock::now() < endtime && !stopFlag.load())
+                    this_thread::sleep_for(std::min(SLEEP_TIME,memoryFlags.stallTime));
+            };
+
+            barrier.arrive_and_wait(); //Wait for main to do stuff
+            while(!stopFlag.load()){
+                auto endtime = steady_clock::now() + memoryFlags.stallPeriod;
+                while(steady_clock::now() < endtime){
+                    for(size_t i = 0; i < GRANULARITY; i++){
+                        if(stopFlag.load()) return;
+                        queue->pop(tid);
+                        random_additional_work(consumerAdditionalWork);
+                    }
+                }
+                if constexpr (requires{ queue->stalledPop(tid,stall); })
+                    queue->stalledPop(tid,stall);
+                else stall();
+            }
+        };
     
         queue = new Q<UserData>(ringSize, producers + consumers);
         //customize signal mask
@@ -305,11 +340,14 @@ private:
                 threads.thread(prod);
         }
         
+        for(size_t iCons = 0; iCons < memoryFlags.stalledConsumers && iCons < consumers; iCons++)
+            threads.thread(cons_stalled);
+        const size_t runningConsumers = consumers - std::min(memoryFlags.stalledConsumers,consumers);
         if(memoryFlags.level | MemoryControl::CONS){
-            for(int iCons = 0; iCons < consumers; iCons++)
+            for(size_t iCons = 0; iCons < runningConsumers; iCons++)
                 threads.thread(cons_sync);
         } else {
-            for(int iCons = 0; iCons < consumers; iCons++)
+            for(size_t iCons = 0; iCons < runningConsumers; iCons++)
                 threads.thread(cons);
         }
         
@@ -329,6 +367,10 @@ private:
         puts("WAITING FOR JOIN");
         threads.join();
         puts("JOINED");
+        if constexpr (requires{ queue->getReclaimStats(); }){
+            if(flags._stdout)
+                printReclaimStats(queue->getReclaimStats());
+        }
         delete (Q<UserData>*) queue;    //automatically drains the queue and deallocates it
         int status;
         waitpid(pid,&status,0); //wait for memoryMonitor to finish
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <iostream>
 #include <barrier>
+#include <sys/resource.h>
 
 #include "Benchmark.hpp"
 #include "ThreadGroup.hpp"
@@ -13,6 +14,8 @@
 namespace bench {
 
 class ProdConsBenchmark: public Benchmark{
+    static constexpr milliseconds POP_WAIT_TIMEOUT{1};  //parked consumers check the stop flag at least every timeout
+
 public:
     size_t producers, consumers;
     size_t warmup;
@@ -21,6 +24,13 @@ public:
     double producerAdditionalWork;
     double consumerAdditionalWork;
     bool balancedLoad;
+    size_t batchSize;   //items moved per pushBatch/popBatch (1: single operations)
+    bool blocking;      //consumers park on popWait instead of spinning on pop
+    bool payload = false;   //set by runPayloadSeries: Message payloads read by the consumers (__Payload)
+    uint64_t payloadErrors = 0; //payload mode: messages out of order or from an unknown producer
+    vector<long double> cpuNsPerItem;   //process CPU time (user + system) per transferred item, for every run
+    ReclaimStats reclaimStats{};    //memory reclamation statistics over all runs
+    PushStats pushStats{};          //slow path pushes and forced closes over all runs
     Arguments flags;
 
 public:
@@ -30,7 +40,9 @@ public:
                         bool balanced,
                         size_t ringSize = RINGSIZE,
                         size_t warmup = WARMUP,
-                        Arguments args = Arguments()
+                        Arguments args = Arguments(),
+                        size_t batch = 1,
+                        bool blockingCons = false
                     ):
     producers{prodCount},
     consumers{consCount},
@@ -39,6 +51,8 @@ public:
     ringSize{ringSize},
     balancedLoad{balanced},
     warmup{warmup},
+    batchSize{batch},
+    blocking{blockingCons},
     flags{args}{
         if(producers == 0 || consumers == 0)
             throw invalid_argument("Threads count must be greater than 0");
@@ -46,7 +60,9 @@ public:
             throw invalid_argument("Ring Size must be greater than 0");
         else if(additionalWork < 0)
             throw invalid_argument("Additional Work must be greater than 0");
-        
+        else if(batchSize == 0)
+            throw invalid_argument("Batch Size must be greater than 0");
+        setClusterMode(flags._cluster);
 
         if(balanced){
             const size_t total  = producers + consumers;
@@ -67,6 +83,9 @@ public:
         Stats<long double> sts = stats(res.begin(),res.end());
         if(flags._stdout){
             printBenchmarkResults(Q<UserData>::className(),"Transf/Sec",sts.mean,sts.stddev);
+            printCpuPerItem(cpuNsPerItem);
+            printReclaimStats(reclaimStats);
+            printPushStats(pushStats);
         }
         if(fileName != ""){
             bool header = flags._overwrite || !fileExists(fileName);
@@ -93,11 +112,33 @@ public:
         uint32_t prodConsGcd = GCD(producers,consumers);
         uint32_t prodRatio = producers / prodConsGcd;
         uint32_t consRatio = consumers / prodConsGcd;
-        benchmark << "producerConsumer[" << prodRatio << "/" << consRatio << (balancedLoad? "|balanced":"") << "]";
+        benchmark << "producerConsumer[" << prodRatio << "/" << consRatio << (balancedLoad? "|balanced":"");
+        if(batchSize > 1)
+            benchmark << "|batch=" << batchSize;
+        if(blocking)
+            benchmark << "|blocking";
+        if(payload)
+            benchmark << "|payload";
+        benchmark << "]";
         return benchmark.str();
     }
 
 private:
+    //CPU time (user + system) consumed by the process so far
+    static nanoseconds processCpuTime(){
+        rusage usage{};
+        getrusage(RUSAGE_SELF,&usage);
+        auto toNs = [](const timeval& tv){ return seconds{tv.tv_sec} + microseconds{tv.tv_usec}; };
+        return duration_cast<nanoseconds>(toNs(usage.ru_utime) + toNs(usage.ru_stime));
+    }
+
+    static void printCpuPerItem(const vector<long double>& cpuNs){
+        if(cpuNs.empty()) return;
+        Stats<long double> sts = stats(cpuNs.begin(),cpuNs.end());
+        printStat("CPU ns/item",sts.mean,1);
+        cout << string(40, '#') << endl;
+    }
+
 template<template<typename> typename Q>
     vector<long double> __ProducerConsumer(seconds runDuration, size_t numRuns){
         using namespace std;
@@ -108,10 +149,24 @@ template<template<typename> typename Q>
         pair<uint64_t,uint64_t> transferredCount[consumers][numRuns];
 
         bool constexpr bounded = BoundedQueues::Contains<Q>;    //checks if the queue is bounded
+        if(SPSCQueues::Contains<Q> && (producers != 1 || consumers != 1))
+            throw invalid_argument(Q<UserData>::className() + " supports a single producer and a single consumer");
+        if(MPSCQueues::Contains<Q> && consumers != 1)
+            throw invalid_argument(Q<UserData>::className() + " supports a single consumer");
+        bool constexpr batched = requires(Q<UserData>* q, UserData** items){   //checks if the queue has the batch API
+            q->pushBatch(items, size_t{1}, 0);
+            q->popBatch(items, size_t{1}, 0);
+        };
+        if(batchSize > 1 && !batched)
+            throw invalid_argument(Q<UserData>::className() + " does not support batched operations");
+        bool constexpr blockable = requires(Q<UserData>* q){ q->popWait(0,milliseconds{1}); };
+        if(blocking && !blockable)
+            throw invalid_argument(Q<UserData>::className() + " does not support blocking pops");
 
         const auto prod_lambda = [this,&stopFlag,&queue,&barrier](const int tid){
             UserData ud{};
             uint64_t iter = 0;
+            vector<UserData*> batch(batchSize,&ud);
             //Warmup Iterations
             barrier.arrive_and_wait();
             for(size_t iter = 0; iter < warmup; ++iter)
@@ -121,7 +176,7 @@ template<template<typename> typename Q>
             barrier.arrive_and_wait();
             while(!stopFlag.load()){
                 //If balance load we "slow down" producers every few iterations
-                if constexpr((BoundedQueues::Append<LinkedMuxQueue>::template Contains<Q>))
+                if constexpr((BoundedQueues::Append<LinkedMuxQueue>::Cat<ConsumerLengthQueues>::template Contains<Q>))
                 {  //BoundedQueues is problematic
                     if((iter &((1ull << 5)-1)) != 0 ||//every 31 iterations
                     !balancedLoad) {
@@ -133,7 +188,12 @@ template<template<typename> typename Q>
                     if((iter &((1ull << 5)-1)) != 0 ||//every 31 iterations
                     !balancedLoad                   ||
                     (queue->length(tid) < ringSize * 7 / 10)) {
-                        queue->push(&ud,tid);
+                        if constexpr (batched){
+                            if(batchSize > 1)
+                                queue->pushBatch(batch.data(),batchSize,tid);
+                            else queue->push(&ud,tid);
+                        }
+                        else queue->push(&ud,tid);
                         ++iter;
                     }
                 }
@@ -146,6 +206,7 @@ template<template<typename> typename Q>
             UserData placeholder;
             uint64_t successfulDeqCount = 0;
             uint64_t failedDeqCount = 0;
+            vector<UserData*> batch(batchSize);
 
             barrier.arrive_and_wait();
             //Warmup    Iterations
@@ -157,7 +218,21 @@ template<template<typename> typename Q>
             while(queue->pop(tid) != nullptr){}
             barrier.arrive_and_wait();
             while(!stopFlag.load()){
-                UserData *d = queue->pop(tid);
+                if constexpr (batched){
+                    if(batchSize > 1){
+                        size_t got = queue->popBatch(batch.data(),batchSize,tid);
+                        if(got != 0)
+                            successfulDeqCount += got;
+                        else ++failedDeqCount;
+                        random_additional_work(consumerAdditionalWork);
+                        continue;
+                    }
+                }
+                UserData *d = nullptr;
+                if constexpr (blockable){
+                    d = blocking? queue->popWait(tid,POP_WAIT_TIMEOUT) : queue->pop(tid);
+                }
+                else d = queue->pop(tid);
                 if(d != nullptr) {
                     ++successfulDeqCount;
                 } else ++failedDeqCount;
@@ -183,11 +258,21 @@ template<template<typename> typename Q>
             barrier.arrive_and_wait();  //measurement
 
             auto startBeat = steady_clock::now();
+            const nanoseconds startCpu = processCpuTime();
             std::this_thread::sleep_for(runDuration);
             stopFlag.store(true);   //signal to stop all threads
             auto stopBeat = steady_clock::now();
+            const nanoseconds runCpu = processCpuTime() - startCpu;
             deltas[iRun] = duration_cast<nanoseconds>(stopBeat - startBeat);
             threads.join();
+            uint64_t transferred = 0;
+            for(size_t i = 0; i < consumers; ++i)
+                transferred += transferredCount[i][iRun].first;
+            cpuNsPerItem.push_back(static_cast<long double>(runCpu.count()) / max<uint64_t>(transferred,1));
+            if constexpr (requires{ queue->getReclaimStats(); })
+                reclaimStats += queue->getReclaimStats();
+            if constexpr (requires{ queue->getPushStats(); })
+                pushStats += queue->getPushStats();     //the threads are joined
             delete (Q<UserData>*) queue;    //automatically drains the queue and deallocates it
         }
         //Compute result and return it as a vector
@@ -205,6 +290,119 @@ template<template<typename> typename Q>
         return transfersPerSec;
     }
 
+    /*
+        Payload mode: the producers send Message values (producer id and sequence
+        number) and the consumers read them, checking that the messages of every
+        producer arrive in order, so the cost of reaching the payload is measured.
+        Inline queues (bool pop(Message&,tid), see InlineQueue.hpp) carry the message
+        in their cells, pointer queues carry a Message allocated by the producer and
+        deleted by the consumer. No warmup, bounded queues drop the messages of failed pushes.
+    */
+template<template<typename> typename Q>
+    vector<long double> __Payload(seconds runDuration, size_t numRuns){
+        using namespace std;
+        using namespace chrono;
+        using Queue = Q<Message>;
+        Queue* queue = nullptr;
+        barrier<> barrier(producers + consumers + 1);
+        std::atomic<bool> stopFlag{false};
+        pair<uint64_t,uint64_t> transferredCount[consumers][numRuns];   //received messages, payload errors
+
+        bool constexpr inlined = requires(Queue* q, Message& msg){ { q->pop(msg,0) } -> same_as<bool>; };
+        if(SPSCQueues::Contains<Q> && (producers != 1 || consumers != 1))
+            throw invalid_argument(Queue::className() + " supports a single producer and a single consumer");
+        if(MPSCQueues::Contains<Q> && consumers != 1)
+            throw invalid_argument(Queue::className() + " supports a single consumer");
+
+        const auto prod_lambda = [this,&stopFlag,&queue,&barrier](const int tid){
+            uint32_t seq = 0;
+            barrier.arrive_and_wait();
+            while(!stopFlag.load()){
+                const Message msg{static_cast<uint32_t>(tid),++seq};
+                if constexpr (inlined)
+                    queue->push(msg,tid);
+                else {
+                    Message* item = new Message{msg};
+                    if constexpr (requires{ { queue->push(item,tid) } -> same_as<bool>; }){
+                        if(!queue->push(item,tid))
+                            delete item;
+                    }
+                    else queue->push(item,tid);
+                }
+                random_additional_work(producerAdditionalWork);
+            }
+        };
+
+        const auto cons_lambda = [this,&stopFlag,&queue,&barrier](const int tid){
+            vector<uint32_t> lastSeq(producers,0);  //producers get the first thread ids
+            uint64_t received = 0;
+            uint64_t errors = 0;
+            barrier.arrive_and_wait();
+            while(!stopFlag.load()){
+                Message msg;
+                bool got;
+                if constexpr (inlined)
+                    got = queue->pop(msg,tid);
+                else {
+                    Message* item = queue->pop(tid);
+                    got = item != nullptr;
+                    if(got){
+                        msg = *item;
+                        delete item;
+                    }
+                }
+                if(got){
+                    ++received;
+                    if(msg.producer >= producers || msg.seq <= lastSeq[msg.producer])
+                        ++errors;
+                    else lastSeq[msg.producer] = msg.seq;
+                }
+                random_additional_work(consumerAdditionalWork);
+            }
+            return pair{received, errors};
+        };
+
+        nanoseconds deltas[numRuns];
+        for(size_t iRun = 0; iRun < numRuns; iRun++){
+            queue = new Queue(ringSize, producers + consumers);
+            ThreadGroup threads{};
+            for(size_t iProd = 0; iProd < producers; iProd++)
+                threads.thread(prod_lambda);
+            for(size_t iCons = 0; iCons < consumers; iCons++)
+                threads.threadWithResult(cons_lambda,transferredCount[iCons][iRun]);
+            barrier.arrive_and_wait();
+
+            auto startBeat = steady_clock::now();
+            const nanoseconds startCpu = processCpuTime();
+            std::this_thread::sleep_for(runDuration);
+            stopFlag.store(true);
+            auto stopBeat = steady_clock::now();
+            const nanoseconds runCpu = processCpuTime() - startCpu;
+            deltas[iRun] = duration_cast<nanoseconds>(stopBeat - startBeat);
+            threads.join();
+            stopFlag.store(false);
+            uint64_t transferred = 0;
+            for(size_t i = 0; i < consumers; ++i){
+                transferred += transferredCount[i][iRun].first;
+                payloadErrors += transferredCount[i][iRun].second;
+            }
+            cpuNsPerItem.push_back(static_cast<long double>(runCpu.count()) / max<uint64_t>(transferred,1));
+            if constexpr (!inlined){
+                while(Message* item = queue->pop(0))    //messages left by the producers
+                    delete item;
+            }
+            delete queue;
+        }
+        vector<long double> transfersPerSec(numRuns);
+        for(size_t iRun = 0; iRun < numRuns; iRun++){
+            uint64_t totalTransfersCount = 0;
+            for(size_t i = 0; i < consumers; ++i)
+                totalTransfersCount += transferredCount[i][iRun].first;
+            transfersPerSec[iRun] = static_cast<long double>(totalTransfersCount * NSEC_SEC) / deltas[iRun].count();
+        }
+        return transfersPerSec;
+    }
+
 
 
 public:
@@ -259,8 +457,11 @@ public:
                                     if(totalTimeInSec > 0)
                                     cout << "Time Remaining " << formatTime(totalTimeInSec) << "\n";
                                 }
-                                if(args._stdout)
+                                if(args._stdout){
                                     printBenchmarkResults(Q<UserData>::className(),"Transf/Sec",sts.mean,sts.stddev);
+                                    printReclaimStats(bench.reclaimStats);
+                                    printPushStats(bench.pushStats);
+                                }
                             }
                         }
                     }
@@ -335,8 +536,11 @@ public:
                                 if(totalTimeInSec > 0)
                                 cout << "Time Remaining " << formatTime(totalTimeInSec) << "\n";
                             }
-                            if(args._stdout)
+                            if(args._stdout){
                                 printBenchmarkResults(Q<UserData>::className(),"Transf/Sec",sts.mean,sts.stddev);
+                                printReclaimStats(bench.reclaimStats);
+                                printPushStats(bench.pushStats);
+                            }
                         }
                     }
                 }   
@@ -345,6 +549,160 @@ public:
        
     }
 
+    /*
+        K:1 series for the single consumer queues (and their multi consumer
+        counterparts): runs nProd producers against one consumer for every nProd
+    */
+    template<template<typename> typename Q>
+    static void runMPSCSeries  (std::string csvFileName,
+                                const vector<size_t> producerSet,
+                                const size_t queueSize,
+                                const double additionalWork,
+                                const seconds runDuration,
+                                const size_t numRuns,
+                                const Arguments args=Arguments())
+    {
+        runSeries<Q>(csvFileName,producerSet,vector<size_t>{1},{queueSize},{additionalWork},{WARMUP},runDuration,numRuns,false,args);
+    }
+
+    /*
+        Batch size sweep: runs the same producer/consumer configuration once for
+        every batch size in batchSet (1 measures the single push/pop baseline)
+    */
+    template<template<typename> typename Q>
+    static void runBatchSeries (std::string csvFileName,
+                                const size_t nProd,
+                                const size_t nCons,
+                                vector<size_t> batchSet,
+                                const size_t queueSize,
+                                const seconds runDuration,
+                                const size_t numRuns,
+                                const Arguments args=Arguments())
+    {
+        if(batchSet.empty()) batchSet = {1};
+
+        //CSV-HEADER
+        bool header = args._overwrite || fileExists(csvFileName) == false;
+        ofstream csvFile(csvFileName,header? ios::trunc : ios::app);
+        if(header)
+            ThroughputCSVHeader(csvFile);
+
+        const int totalTests = batchSet.size();
+        uint64_t runTime_sec = runDuration.count();
+        uint64_t totalTimeInSec = totalTests * numRuns * runTime_sec;
+        int iTest = 0;
+        if(args._progress)
+            cout    << "Time Remaining " << formatTime(totalTimeInSec) << "\n";
+
+        for(size_t batch : batchSet){
+            ProdConsBenchmark bench(nProd,nCons,0.0,false,queueSize,WARMUP,args,batch);
+            std::vector<long double> result = bench.__ProducerConsumer<Q>(runDuration,numRuns);
+            Stats sts = stats(result.begin(),result.end());
+            ThroughputCSVData(  csvFile,
+                                bench.toString(),
+                                Q<UserData>::className(),
+                                nProd+nCons,
+                                0.0,
+                                queueSize,
+                                static_cast<uint64_t>(runTime_sec),
+                                numRuns,
+                                sts
+                                );
+            iTest++;
+            if(args._progress){
+                totalTimeInSec -= (runTime_sec*numRuns);
+                cout    << "Executed " << iTest << " of " << totalTests << " runs\n";
+                if(totalTimeInSec > 0)
+                    cout << "Time Remaining " << formatTime(totalTimeInSec) << "\n";
+            }
+            if(args._stdout){
+                printBenchmarkResults(Q<UserData>::className() + " batch " + to_string(batch),"Transf/Sec",sts.mean,sts.stddev);
+                printReclaimStats(bench.reclaimStats);
+                printPushStats(bench.pushStats);
+            }
+        }
+    }
+
+    /*
+        Spinning vs blocking consumers: runs the same producer/consumer configuration
+        with consumers spinning on pop and parked on popWait.
+        The CSV reports the CPU time per transferred item next to the throughput
+    */
+    template<template<typename> typename Q>
+    static void runBlockingSeries  (std::string csvFileName,
+                                    const size_t nProd,
+                                    const size_t nCons,
+                                    const size_t queueSize,
+                                    const double additionalWork,
+                                    const seconds runDuration,
+                                    const size_t numRuns,
+                                    const Arguments args=Arguments())
+    {
+        bool header = args._overwrite || fileExists(csvFileName) == false;
+        ofstream csvFile(csvFileName,header? ios::trunc : ios::app);
+        if(header)
+            csvFile << "Benchmark,QueueType,Threads,AdditionalWork,RingSize,"
+                    << "Duration,Iterations,Score,ScoreError,CpuNsPerItem,Cluster" << endl;
+
+        for(bool blocking : {false,true}){
+            ProdConsBenchmark bench(nProd,nCons,additionalWork,false,queueSize,WARMUP,args,1,blocking);
+            std::vector<long double> result = bench.__ProducerConsumer<Q>(runDuration,numRuns);
+            Stats sts = stats(result.begin(),result.end());
+            Stats cpu = stats(bench.cpuNsPerItem.begin(),bench.cpuNsPerItem.end());
+            csvFile << bench.toString() << "," << Q<UserData>::className() << "," << nProd + nCons << ","
+                    << additionalWork << "," << queueSize << "," << runDuration.count() << "," << numRuns << ","
+                    << static_cast<uint64_t>(sts.mean) << "," << sts.stddev << "," << cpu.mean << ","
+                    << clusterModeName(getClusterMode()) << endl;
+            if(args._stdout){
+                printBenchmarkResults(Q<UserData>::className() + (blocking? " blocking" : " spinning"),"Transf/Sec",sts.mean,sts.stddev);
+                printCpuPerItem(bench.cpuNsPerItem);
+                printReclaimStats(bench.reclaimStats);
+                printPushStats(bench.pushStats);
+            }
+        }
+    }
+
+    /*
+        Payload series: producer/consumer runs in payload mode (see __Payload), to compare
+        the inline queues against the pointer queues carrying heap allocated messages
+    */
+    template<template<typename> typename Q>
+    static void runPayloadSeries   (std::string csvFileName,
+                                    const size_t nProd,
+                                    const size_t nCons,
+                                    const size_t queueSize,
+                                    const double additionalWork,
+                                    const seconds runDuration,
+                                    const size_t numRuns,
+                                    const Arguments args=Arguments())
+    {
+        bool header = args._overwrite || fileExists(csvFileName) == false;
+        ofstream csvFile(csvFileName,header? ios::trunc : ios::app);
+        if(header)
+            ThroughputCSVHeader(csvFile);
+
+        ProdConsBenchmark bench(nProd,nCons,additionalWork,false,queueSize,WARMUP,args);
+        bench.payload = true;
+        std::vector<long double> result = bench.__Payload<Q>(runDuration,numRuns);
+        Stats sts = stats(result.begin(),result.end());
+        ThroughputCSVData(  csvFile,
+                            bench.toString(),
+                            Q<Message>::className(),
+                            nProd+nCons,
+                            additionalWork,
+                            queueSize,
+                            static_cast<uint64_t>(runDuration.count()),
+                            numRuns,
+                            sts
+                            );
+        if(args._stdout){
+            printBenchmarkResults(Q<Message>::className() + " payload","Transf/Sec",sts.mean,sts.stddev);
+            printCpuPerItem(bench.cpuNsPerItem);
+            if(bench.payloadErrors != 0)
+                cout << "Payload errors: " << bench.payloadErrors << endl;
+        }
+    }
+
     // static void runSeries(Format format){   //change format to json parsing
     //     for(string q : format.queueFilter){
     //         Queues::foreach([&q,&format]<template <typename> typename Q>() {
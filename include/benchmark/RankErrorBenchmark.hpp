@@ -0,0 +1,206 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <barrier>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <cassert>
+
+#include "Benchmark.hpp"        //  for benchmarking Base Class
+#include "ThreadGroup.hpp"      //  for thread management
+#include "Stats.hpp"            //  for average and stddev computation
+#include "QueueTypeSet.hpp"
+
+namespace bench {
+
+/*
+    Throughput against FIFO relaxation (e.g. ShardedQueue against its inner queue).
+
+    Every producer pushes IterNum items stamped with a global push sequence
+    number (taken right before the push); every successful pop takes a global
+    pop sequence number. The rank error of a pop is the distance between the
+    two: 0 for every pop of a FIFO queue used by one thread, a few units for a
+    concurrent FIFO queue (the timestamps are not taken atomically with the
+    operations), up to the number of items in the queue for a relaxed one.
+    Reports transfers/sec, mean and max rank error.
+*/
+class RankErrorBenchmark: public Benchmark {
+public:
+    //item stamped by the producer
+    struct Item {
+        uint64_t seq = 0;
+    };
+
+    Arguments flags;
+    size_t producers, consumers;
+    size_t ringSize;
+    long double meanRankError = 0;
+    uint64_t maxRankError = 0;
+
+    RankErrorBenchmark(size_t prodCount,
+                       size_t consCount,
+                       size_t ringSz = RINGSIZE,
+                       Arguments flags = Arguments()):
+    flags{flags}, producers{prodCount}, consumers{consCount}, ringSize{ringSz} {
+        if(producers == 0 || consumers == 0)    throw invalid_argument("Threads count must be greater than 0");
+        if(ringSize == 0)                       throw invalid_argument("Ring Size must be greater than 0");
+        setClusterMode(flags._cluster);
+    }
+
+    string toString() const {
+        return "rankError[" + to_string(producers) + "/" + to_string(consumers) + "]";
+    }
+
+    template<template<typename> typename Q>
+    void run(const size_t IterNum, const size_t numRuns, const std::string fileName = ""){
+        auto res = __RankError<Q>(IterNum,numRuns);
+        Stats<long double> sts = stats(res.begin(),res.end());
+        const string name = Q<Item>::className();
+
+        if(flags._stdout){
+            printBenchmarkResults(name,"Transf/Sec",sts.mean,sts.stddev);
+            printRankError(meanRankError,maxRankError);
+        }
+
+        if(fileName != ""){
+            bool header = flags._overwrite || !fileExists(fileName);
+            ofstream csv(fileName, header? ios::trunc : ios::app);
+            if(header) RankErrorCSVHeader(csv);
+            RankErrorCSVData(csv,name,IterNum,numRuns,sts);
+            csv.close();
+        }
+    }
+
+private:
+    static void printRankError(long double mean, uint64_t max){
+        printStat("Mean rank error",mean,2);
+        printStat("Max rank error",max);
+        cout << string(40, '#') << endl;
+    }
+
+    template<template<typename> typename Q>
+    vector<long double> __RankError(const size_t IterNum, const size_t numRuns){
+        using namespace std;
+        using namespace chrono;
+        using Queue = Q<Item>;
+
+        if(SPSCQueues::Contains<Q> && (producers != 1 || consumers != 1))
+            throw invalid_argument(Queue::className() + " supports a single producer and a single consumer");
+        if(MPSCQueues::Contains<Q> && consumers != 1)
+            throw invalid_argument(Queue::className() + " supports a single consumer");
+        bool constexpr bounded = requires(Queue* q, Item* item){ { q->push(item,0) } -> std::same_as<bool>; };
+
+        const uint64_t total = IterNum * producers;
+        vector<vector<Item>> items(producers,vector<Item>(IterNum));
+        vector<pair<uint64_t,uint64_t>> rankErrors(consumers);    //sum and max of every consumer
+        Queue* queue = nullptr;
+        atomic<uint64_t> pushSeq{0}, popSeq{0};
+        barrier<> barrier(producers + consumers + 1);
+
+        const auto prod_lambda = [&](const int tid){
+            vector<Item>& mine = items[tid];
+            barrier.arrive_and_wait();
+            for(Item& item : mine){
+                item.seq = pushSeq.fetch_add(1);
+                if constexpr (bounded){
+                    while(!queue->push(&item,tid));
+                } else
+                    queue->push(&item,tid);
+            }
+        };
+
+        const auto cons_lambda = [&](const int tid){
+            uint64_t sum = 0, max = 0;
+            barrier.arrive_and_wait();
+            while(popSeq.load(memory_order_relaxed) < total){
+                Item* item = queue->pop(tid);
+                if(item == nullptr) continue;
+                const uint64_t rank = popSeq.fetch_add(1);
+                const uint64_t error = item->seq > rank ? item->seq - rank : rank - item->seq;
+                sum += error;
+                max = std::max(max,error);
+            }
+            rankErrors[tid - producers] = {sum,max};
+        };
+
+        vector<long double> transfersPerSec(numRuns);
+        long double errorSum = 0;
+        maxRankError = 0;
+        for(size_t iRun = 0; iRun < numRuns; iRun++){
+            queue = new Queue(ringSize,producers + consumers);
+            pushSeq.store(0);
+            popSeq.store(0);
+
+            ThreadGroup threads{};
+            for(size_t i = 0; i < producers; i++)
+                threads.thread(prod_lambda);
+            for(size_t i = 0; i < consumers; i++)
+                threads.thread(cons_lambda);
+            barrier.arrive_and_wait();      //starts the run
+            auto startBeat = steady_clock::now();
+            threads.join();
+            auto stopBeat = steady_clock::now();
+            delete queue;
+
+            transfersPerSec[iRun] = static_cast<long double>(total * NSEC_SEC) / duration_cast<nanoseconds>(stopBeat - startBeat).count();
+            for(auto [sum,max] : rankErrors){
+                errorSum += sum;
+                maxRankError = std::max(maxRankError,max);
+            }
+        }
+        meanRankError = errorSum / (total * numRuns);
+        return transfersPerSec;
+    }
+
+    static void RankErrorCSVHeader(std::ostream& stream){
+        stream  << "Benchmark,QueueType,Producers,Consumers,RingSize,Iterations,Runs,"
+                << "Score,ScoreError,MeanRankError,MaxRankError,Cluster" << endl;
+    }
+
+    void RankErrorCSVData(std::ostream& stream, std::string_view queueType, size_t iterations,
+                          size_t numRuns, const Stats<long double> stats) const {
+        stream  << toString() << "," << queueType << "," << producers << "," << consumers << ","
+                << ringSize << "," << iterations << "," << numRuns << ","
+                << static_cast<uint64_t>(stats.mean) << "," << static_cast<long double>(stats.stddev) << ","
+                << meanRankError << "," << maxRankError << "," << clusterModeName(getClusterMode()) << endl;
+    }
+
+public:
+    /*
+        Runs every producers / consumers pair (same index of the two sets)
+    */
+    template<template<typename> typename Q>
+    static void runSeries  (const std::string csvFileName,
+                            const vector<size_t> producerSet,
+                            const vector<size_t> consumerSet,
+                            const size_t ringSize,
+                            const size_t IterNum,
+                            const size_t numRuns,
+                            const Arguments args=Arguments())
+    {
+        assert(producerSet.size() == consumerSet.size());
+        bool header = args._overwrite || !fileExists(csvFileName);
+        ofstream csvFile(csvFileName,header? ios::trunc : ios::app);
+        if(header)
+            RankErrorCSVHeader(csvFile);
+
+        for(size_t i = 0; i < producerSet.size(); i++){
+            RankErrorBenchmark bench(producerSet[i],consumerSet[i],ringSize,args);
+            std::vector<long double> result = bench.__RankError<Q>(IterNum,numRuns);
+            Stats<long double> sts = stats(result.begin(),result.end());
+            bench.RankErrorCSVData(csvFile,Q<Item>::className(),IterNum,numRuns,sts);
+            if(args._progress)
+                cout << "Executed " << i + 1 << " of " << producerSet.size() << " runs" << endl;
+            if(args._stdout){
+                printBenchmarkResults(Q<Item>::className(),"Transf/Sec",sts.mean,sts.stddev);
+                printRankError(bench.meanRankError,bench.maxRankError);
+            }
+        }
+    }
+};
+
+}
@@ -27,6 +27,7 @@ public:
     size_t ringSize;
     size_t warmup;
     double additionalWork;
+    ReclaimStats reclaimStats{};    //memory reclamation statistics over all runs
 
     SymmetricBenchmark( size_t threads_par, 
                         double additionalWork_par, 
@@ -38,6 +39,7 @@ public:
         if(threads == 0)        throw invalid_argument("Threads must be greater than 0");
         if(ringSize == 0)       throw invalid_argument("Ring Size must be greater than 0");
         if(additionalWork < 0)  throw invalid_argument("Additional Work must be greater than 0");
+        setClusterMode(flags._cluster);
     }
 
     SymmetricBenchmark( size_t threads, double additionalWork):
@@ -55,6 +57,8 @@ public:
 
         if(flags._stdout){ 
             printBenchmarkResults(Q<UserData>::className(),"Ops/Sec",sts.mean,sts.stddev);
+            printSlotBytes(slotBytes<Q>());
+            printReclaimStats(reclaimStats);
         }
 
         if(fileName != ""){
@@ -76,6 +80,21 @@ public:
     }
 
 private:
+    //memory taken by every slot of the queue (0 if the queue does not report it)
+    template<template<typename> typename Q>
+    static constexpr size_t slotBytes(){
+        if constexpr (requires{ Q<UserData>::bytesPerSlot(); })
+            return Q<UserData>::bytesPerSlot();
+        else
+            return 0;
+    }
+
+    static void printSlotBytes(size_t bytes){
+        if(bytes == 0) return;
+        printStat("Bytes/slot",bytes);
+        cout << string(40, '#') << endl;
+    }
+
     template<template<typename> typename Q>
     vector<long double>__EnqDeqBenchmark(const size_t IterNum, const size_t numRuns){
         using namespace std;
@@ -89,15 +108,25 @@ private:
         atomic<size_t> warmupCounter{0};
 
         bool constexpr bounded = BoundedQueues::Contains<Q>;    //checks if the queue is bounded
+        if(MPSCQueues::Contains<Q> && threads != 1)
+            throw invalid_argument(Q<UserData>::className() + " supports a single consumer");
+
+        //bounded queues park the producer on pushWait when full (no busy loop on push)
+        const auto boundedPush = [&queue](auto* ud, const int tid){
+            if constexpr (requires{ queue->pushWait(ud,tid); })
+                queue->pushWait(ud,tid);
+            else
+                while(!queue->push(ud,tid));
+        };
 
         //Threads Routine
-        const auto lambda = [this,IterPerThread,WarmupPerThread,&queue,&barrier,&warmupCounter](const int tid) {
+        const auto lambda = [this,IterPerThread,WarmupPerThread,&queue,&barrier,&warmupCounter,&boundedPush](const int tid) {
             UserData ud{};
             barrier.arrive_and_wait();
             //Warmup Iterations
             for( size_t iW = 0; iW < WarmupPerThread; ++iW ){
                 if constexpr(bounded){  //if queue is bounded then checks if operation succeed
-                    while(!queue->push(&ud,tid));
+                    boundedPush(&ud,tid);
                     if(queue->pop(tid) == nullptr)
                         cerr << "Error at warmup iter " << iW << "\n";
                 }
@@ -113,7 +142,7 @@ private:
             auto startBeat = steady_clock::now();
             for(size_t iter = 0 ; iter < IterPerThread; ++iter) {
                 if constexpr(bounded){
-                    while(!queue->push(&ud,tid));
+                    boundedPush(&ud,tid);
                 }
                 else{
                     queue->push(&ud,tid);
@@ -136,6 +165,8 @@ private:
             barrier.arrive_and_wait();      //unlocks Warmup
             threadSet.join();
             warmupCounter.store(0);         //resets warmupCounter
+            if constexpr (requires{ queue->getReclaimStats(); })
+                reclaimStats += queue->getReclaimStats();
             delete (Q<UserData>*) queue;
         }
 
@@ -198,14 +229,48 @@ public:
                         iTest++;
                         if(args._progress)
                             cout << "Executed " << iTest << " of " << totalTests << " runs" << endl;
-                        if(args._stdout)
+                        if(args._stdout){
                             printBenchmarkResults(Q<UserData>::className(),"Transf/Sec",sts.mean,sts.stddev); 
+                            printReclaimStats(bench.reclaimStats);
+                        }
                     }
                 }
             }
         }
     }
 
+    /*
+        Throughput and memory per slot of the ring based queues:
+        one line per number of threads, the CSV adds the bytes taken by every slot
+    */
+    template<template<typename> typename Q>
+    static void runFootprintSeries (const std::string csvFileName,
+                                    const vector<size_t> threadSet,
+                                    const size_t ringSize,
+                                    const size_t IterNum,
+                                    const size_t numRuns,
+                                    const Arguments args=Arguments())
+    {
+        bool header = args._overwrite || !fileExists(csvFileName);
+        ofstream csvFile(csvFileName,header? ios::trunc : ios::app);
+        if(header)
+            csvFile << "Benchmark,QueueType,Threads,RingSize,Iterations,Runs,Score,ScoreError,BytesPerSlot,Cluster" << endl;
+
+        for(size_t nThreads : threadSet){
+            SymmetricBenchmark bench(nThreads,0.0,ringSize,WARMUP,args);
+            std::vector<long double> result = bench.__EnqDeqBenchmark<Q>(IterNum,numRuns);
+            Stats<long double> sts = stats(result.begin(),result.end());
+            csvFile << "EnqDec," << Q<UserData>::className() << "," << nThreads << "," << ringSize << ","
+                    << IterNum << "," << numRuns << "," << static_cast<uint64_t>(sts.mean) << ","
+                    << sts.stddev << "," << slotBytes<Q>() << "," << clusterModeName(getClusterMode()) << endl;
+            if(args._stdout){
+                printBenchmarkResults(Q<UserData>::className(),"Ops/Sec",sts.mean,sts.stddev);
+                printSlotBytes(slotBytes<Q>());
+                printReclaimStats(bench.reclaimStats);
+            }
+        }
+    }
+
     /*
         I should be able to reduce this interface to a standard format like a std::map
     */
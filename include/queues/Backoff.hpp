@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <sched.h>
+
+#include "x86Atomics.hpp"
+
+#ifndef BACKOFF_MIN     //pause iterations of the first backoff
+#define BACKOFF_MIN 4UL
+#endif
+
+#ifndef BACKOFF_MAX     //pause iterations the exponential backoff saturates to
+#define BACKOFF_MAX 1024UL
+#endif
+
+#ifndef BACKOFF_SPINS   //backoffs of YieldBackoff spinning before it yields the cpu
+#define BACKOFF_SPINS 8
+#endif
+
+/*
+    Backoff policies of the CAS retry loops (MTQueue).
+    A policy object lives for a single operation: every failed CAS calls wait().
+
+    NoBackoff:      retries immediately
+    ExpBackoff:     BACKOFF_MIN pause, doubled at every failure up to BACKOFF_MAX
+    JitterBackoff:  ExpBackoff with a random wait in [0, current backoff] (spreads
+                    the retries of threads that failed together)
+    YieldBackoff:   ExpBackoff for BACKOFF_SPINS failures, then sched_yield
+                    (oversubscribed runs)
+*/
+struct NoBackoff {
+    static constexpr const char* name = "/nobackoff";
+    inline void wait() {}
+};
+
+namespace detail{
+inline void pauseFor(uint64_t iterations) {
+    for(uint64_t i = 0; i < iterations; i++)
+        CPU_PAUSE();
+}
+}
+
+struct ExpBackoff {
+    static constexpr const char* name = "";
+    uint64_t current = BACKOFF_MIN;
+
+    inline void wait() {
+        detail::pauseFor(current);
+        current = std::min<uint64_t>(current << 1,BACKOFF_MAX);
+    }
+};
+
+struct JitterBackoff {
+    static constexpr const char* name = "/jitter";
+    uint64_t current = BACKOFF_MIN;
+    uint64_t seed = reinterpret_cast<uintptr_t>(this) * 0x9E3779B97F4A7C15ull;  //stack address: differs per thread
+
+    inline void wait() {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;  //xorshift
+        detail::pauseFor(seed % (current + 1));
+        current = std::min<uint64_t>(current << 1,BACKOFF_MAX);
+    }
+};
+
+struct YieldBackoff {
+    static constexpr const char* name = "/yield";
+    uint64_t current = BACKOFF_MIN;
+    int failures = 0;
+
+    inline void wait() {
+        if(failures++ >= BACKOFF_SPINS){
+            sched_yield();
+            return;
+        }
+        detail::pauseFor(current);
+        current = std::min<uint64_t>(current << 1,BACKOFF_MAX);
+    }
+};
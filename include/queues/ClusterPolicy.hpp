@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>  // For alignas
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "x86Atomics.hpp"
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#ifndef CLUSTER_BATCH   //operations of the owner node before it hands the segment to a waiting node
+#define CLUSTER_BATCH 1024
+#endif
+
+#ifndef CLUSTER_HOLD    //nanoseconds the owner node keeps the segment while other nodes are waiting
+#define CLUSTER_HOLD 50000
+#endif
+
+#ifndef CLUSTER_TIMEOUT //microseconds a node waits before taking the segment from an idle owner
+#define CLUSTER_TIMEOUT 100
+#endif
+
+#ifndef CLUSTER_SPIN    //pause iterations between two clock reads
+#define CLUSTER_SPIN 64
+#endif
+
+/*
+    Cluster mode of the ring segments, selectable at runtime (setClusterMode)
+    and read once by each segment when it is constructed:
+    Off:    every node operates on the segments at any time
+    Cohort: the operations on a segment are batched per NUMA node (ClusterCohort)
+*/
+enum class ClusterMode { Off, Cohort };
+
+namespace detail{
+inline std::atomic<ClusterMode> clusterMode{ClusterMode::Off};
+}
+
+inline void setClusterMode(ClusterMode mode) {
+    detail::clusterMode.store(mode,std::memory_order_relaxed);
+}
+
+inline ClusterMode getClusterMode() {
+    return detail::clusterMode.load(std::memory_order_relaxed);
+}
+
+//name of the mode in the benchmark arguments and in the CSV files
+inline const char* clusterModeName(ClusterMode mode) {
+    return mode == ClusterMode::Cohort ? "Cohort" : "Off";
+}
+
+inline ClusterMode parseClusterMode(std::string_view name) {
+    if(name == "Off")       return ClusterMode::Off;
+    if(name == "Cohort")    return ClusterMode::Cohort;
+    throw std::invalid_argument("Invalid cluster mode: " + std::string(name));
+}
+
+namespace detail{
+
+/*
+    Cohort ownership of a segment by a NUMA node (at most 64 nodes).
+
+    The threads of the owner node go through without waiting. A thread of
+    another node announces its node in the waiting mask and spins (pause) until
+    its node owns the segment. While other nodes are waiting the owner keeps the
+    segment for at most CLUSTER_BATCH operations or CLUSTER_HOLD ns, then hands it
+    to the next waiting node in node order (round robin), so no node waits for
+    more than one turn of the others.
+    An owner node that stops operating never hands off: a waiting thread takes
+    the segment after CLUSTER_TIMEOUT us.
+
+    The ownership only batches the operations, the queue stays correct with
+    any interleaving (the handing off operation still completes).
+*/
+class ClusterCohort {
+private:
+    alignas(CACHE_LINE) std::atomic<uint64_t> owner{0};
+    std::atomic<uint64_t> waiting{0};       //one bit per waiting node
+    std::atomic<int64_t> holdStart{0};      //start of the current turn while nodes wait (ns)
+    alignas(CACHE_LINE) std::atomic<uint64_t> batch{0};    //operations of the owner in this turn
+    std::atomic<uint64_t> handoffs{0};
+
+    static inline int64_t now() {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    static inline uint64_t bit(uint64_t node) { return 1ull << node; }
+
+    //first waiting node after from (cyclic)
+    static inline uint64_t nextWaiting(uint64_t mask, uint64_t from) {
+        const uint64_t after = from == 63 ? 0 : mask & (~0ull << (from + 1));
+        return __builtin_ctzll(after != 0 ? after : mask);
+    }
+
+    bool transfer(uint64_t from, uint64_t to) {
+        if(!owner.compare_exchange_strong(from,to))
+            return false;
+        waiting.fetch_and(~bit(to));
+        batch.store(0,std::memory_order_relaxed);
+        holdStart.store(now(),std::memory_order_relaxed);
+        handoffs.fetch_add(1,std::memory_order_relaxed);
+        return true;
+    }
+
+    void handoff(uint64_t node) {
+        const uint64_t mask = waiting.load() & ~bit(node);
+        if(mask != 0)
+            transfer(node,nextWaiting(mask,node));
+    }
+
+    void wait(uint64_t node) {
+        if(waiting.fetch_or(bit(node)) == 0)
+            holdStart.store(now(),std::memory_order_relaxed);
+        const int64_t deadline = now() + CLUSTER_TIMEOUT * 1000ll;
+        while(true){
+            for(int i = 0; i < CLUSTER_SPIN; i++){
+                if(owner.load(std::memory_order_acquire) == node){
+                    if(waiting.load(std::memory_order_relaxed) & bit(node))   //announced after the transfer
+                        waiting.fetch_and(~bit(node));
+                    return;
+                }
+                CPU_PAUSE();
+            }
+            if(now() >= deadline){  //the owner is idle
+                const uint64_t current = owner.load();
+                if(current == node || transfer(current,node))
+                    return;
+            }
+        }
+    }
+
+public:
+    void reset(uint64_t node) {
+        assert(node < 64);
+        owner.store(node,std::memory_order_relaxed);
+        waiting.store(0,std::memory_order_relaxed);
+        holdStart.store(0,std::memory_order_relaxed);
+        batch.store(0,std::memory_order_relaxed);
+        handoffs.store(0,std::memory_order_relaxed);
+    }
+
+    /*
+        Waits until node owns the segment, hands it off if the turn of node is over
+    */
+    __attribute__((used,always_inline)) void acquire(uint64_t node) {
+        assert(node < 64);
+        if(owner.load(std::memory_order_acquire) != node){
+            wait(node);
+            return;
+        }
+        if(waiting.load(std::memory_order_relaxed) == 0)
+            return;
+        const uint64_t ops = batch.fetch_add(1,std::memory_order_relaxed) + 1;
+        if(ops >= CLUSTER_BATCH ||
+          (ops % CLUSTER_SPIN == 0 && now() - holdStart.load(std::memory_order_relaxed) >= CLUSTER_HOLD))
+            handoff(node);
+    }
+
+    inline uint64_t getOwner() const { return owner.load(); }
+    inline uint64_t getHandoffs() const { return handoffs.load(); }
+};
+
+}
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <stdexcept>
+
+#include "LinkedRingQueue.hpp"
+#include "RQCell.hpp"
+#include "EventCount.hpp"
+#include "NumaAllocator.hpp"
+#include "x86Atomics.hpp"
+#include "numa_support.hpp"
+
+/*
+    CRQ with 8 byte cells: the cell word packs the unsafe bit, a full bit and the
+    62 bit index, so every transition of the CRQ is a single word CAS (no cmpxchg16b)
+    and a cache line holds 8 cells instead of 4 (unpadded CRQueue).
+
+    The item is kept in the payload slot of the ring position (slots[ticket mod size]):
+    - a producer reserves the empty slot (CAS nullptr -> item) before setting the
+      cell full, and releases it if the cell CAS fails
+    - the consumer owning the full cell takes the item and empties the slot before
+      emptying the cell
+    A slot is written only by the producer that reserved it, so a late producer of an
+    older round can't overwrite the item of the cell: it finds the slot taken and
+    fails its ticket like on a full cell.
+
+    Macros:
+    DISABLE_POW2: Disables power of 2 modulo ops
+*/
+template <typename T, bool bounded>
+class CompactCRQueue : public QueueSegmentBase<T, CompactCRQueue<T, bounded>> {
+private:
+
+    using Base = QueueSegmentBase<T, CompactCRQueue<T, bounded>>;
+    using Cell = detail::CompactCell;
+    using Slot = detail::PlainCell<T *, false>;
+
+    static constexpr size_t TRY_CLOSE = 10;
+
+    size_t size;
+#ifndef DISABLE_POW2
+    size_t mask;  //Mask to execute the modulo operation
+#endif
+    detail::NumaArray<Cell> array;   //placed following SEGMENT_NUMA_POLICY
+    detail::NumaArray<Slot> slots;   //payload of the cell at the same position
+
+    //consumers parked by popWait (only the bounded queue blocks: segments are woken by LinkedRingQueue)
+    [[no_unique_address]] std::conditional_t<bounded,EventCount,NoEventCount> notEmpty;
+    //producers parked by pushWait (bounded queue only)
+    [[no_unique_address]] std::conditional_t<bounded,EventCount,NoEventCount> notFull;
+
+    static inline uint64_t index(uint64_t word)  {return word & Cell::INDEX;}
+    static inline uint64_t unsafe(uint64_t word) {return word & Cell::UNSAFE;}
+    static inline bool isFull(uint64_t word)     {return (word & Cell::FULL) != 0;}
+
+    inline size_t position(uint64_t ticket) const {
+#ifndef DISABLE_POW2
+        return ticket & mask;
+#else
+        return ticket % size;
+#endif
+    }
+
+    inline Cell& cellAt(uint64_t ticket) const { return array[position(ticket)]; }
+    inline Slot& slotAt(uint64_t ticket) const { return slots[position(ticket)]; }
+
+    /*
+        Tries to store item in the cell of tailTicket (the ticket is already owned)
+        return: true if the item has been inserted
+    */
+    __attribute__((always_inline)) bool enqueueTicket(const uint64_t tailTicket, T *item)
+    {
+        Cell &cell = cellAt(tailTicket);
+        uint64_t word = cell.word.load();
+        if (isFull(word) || index(word) > tailTicket)
+            return false;
+        if (unsafe(word) && Base::head.load() >= tailTicket)
+            return false;
+
+        Slot &slot = slotAt(tailTicket);
+        T *free = nullptr;
+        if (!slot.val.compare_exchange_strong(free, item))
+            return false;   //reserved by another producer or not yet released by the consumer
+        if (cell.word.compare_exchange_strong(word, Cell::FULL | tailTicket))
+            return true;
+        slot.val.store(nullptr, std::memory_order_release);
+        return false;
+    }
+
+    /*
+        Consumes the cell of headTicket (the ticket is already owned)
+        return: the item stored for headTicket or nullptr if the cell has been
+                invalidated (empty or unsafe transition)
+    */
+    __attribute__((always_inline)) T *dequeueTicket(const uint64_t headTicket)
+    {
+        Cell &cell = cellAt(headTicket);
+
+        int r = 0;
+        uint64_t tt = 0;
+
+        while (true)
+        {
+            uint64_t word = cell.word.load();
+            uint64_t idx = index(word);
+
+            if (idx > headTicket)
+                return nullptr;
+
+            if (isFull(word))
+            {
+                if (idx == headTicket)
+                {
+                    Slot &slot = slotAt(headTicket);
+                    T *item = slot.val.load(std::memory_order_acquire);
+                    slot.val.store(nullptr, std::memory_order_release);
+                    //the cell stays full until this CAS: only the unsafe bit can change meanwhile
+                    while (!cell.word.compare_exchange_weak(word, unsafe(word) | (headTicket + size)));
+                    return item;
+                }
+                else
+                { // Unsafe Transition
+                    if (cell.word.compare_exchange_strong(word, word | Cell::UNSAFE))
+                        return nullptr;
+                }
+            }
+            else
+            { // Void Transition
+                if ((r & ((1ull << 8) - 1)) == 0)
+                    tt = Base::tail.load();
+
+                int closed = Base::isClosed(tt);
+                uint64_t t = Base::tailIndex(tt);
+                if (unsafe(word) || t < headTicket + 1 || closed || r > 4 * 1024 )
+                {
+                    if (cell.word.compare_exchange_strong(word, unsafe(word) | (headTicket + size)))
+                        return nullptr;
+                }
+                ++r;
+            }
+        }
+    }
+
+private:
+    CompactCRQueue(size_t size_par,[[maybe_unused]] const int tid, const uint64_t start): Base(),
+#ifndef DISABLE_POW2
+    size{detail::nextPowTwo(size_par)},
+    mask{size - 1}
+#else
+    size{size_par}
+#endif
+    {
+        if(size_par == 0)
+            throw std::invalid_argument("Ring Size must be greater than 0");
+        array = detail::NumaArray<Cell>(size);
+        slots = detail::NumaArray<Slot>(size);
+        init(start);
+    }
+
+    /*
+        (Re)initializes the ring to start from the given index: used by the constructor
+        and by LinkedRingQueue to recycle a retired segment without reallocating it
+    */
+    void init(const uint64_t start){
+        for(uint64_t i = start; i < start + size; ++i){
+            slotAt(i).val.store(nullptr,std::memory_order_relaxed);
+            cellAt(i).word.store(i,std::memory_order_relaxed);
+        }
+
+        Base::head.store(start,std::memory_order_relaxed);
+        Base::tail.store(start,std::memory_order_relaxed);
+        Base::next.store(nullptr,std::memory_order_relaxed);
+        //Numa optimization
+        Base::cohort.reset(Base::clusterNode());
+    }
+
+
+public:
+    //uses the tid argument to be consistent with linked queues
+    CompactCRQueue(size_t size_par,[[maybe_unused]] const int tid = 0): CompactCRQueue(size_par,tid,0){}
+
+    ~CompactCRQueue() {
+        while(pop(0) != nullptr);
+    }
+
+    //the cells are never padded: the padding argument is ignored
+    static std::string className([[maybe_unused]] bool padding = true){
+        using namespace std::string_literals;
+        return (bounded? "Bounded"s : ""s) + "CompactCRQueue"s;
+    }
+
+    //memory taken by every slot of the ring (cell word and payload slot)
+    static constexpr size_t bytesPerSlot() {
+        return sizeof(Cell) + sizeof(Slot);
+    }
+
+    /*
+        Takes an additional tid parameter to keep the interface compatible with
+        LinkedRingQueue->push
+        The parameter has a default value so that it can be omitted
+    */
+    __attribute__((used,always_inline)) bool push(T *item,[[maybe_unused]] const int tid = 0)
+    {
+        size_t try_close = 0;
+
+        while (true)
+        {
+            Base::safeCluster();
+            uint64_t tailTicket = Base::tail.fetch_add(1);
+
+            if constexpr (bounded == false){    //if LinkedRingQueue Segment then checks if the segment is closed
+                if(Base::isClosed(tailTicket)){
+                    return false;
+                }
+            }
+
+            if (enqueueTicket(tailTicket, item)) {
+                notEmpty.notify();   //a load if no consumer is parked
+                return true;
+            }
+
+            if (tailTicket >= Base::head.load() + size)
+            {
+                if constexpr (bounded){ //if queue is bounded then never closes the segment
+                    return false;
+                }
+                else{
+                    if (Base::closeSegment(tailTicket, ++try_close > TRY_CLOSE)){
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+     /*
+        Takes an additional tid parameter to keep the interface compatible with
+        LinkedRingQueue->pop
+        The parameter has a default value so that it can be omitted
+    */
+    __attribute__((used,always_inline)) T *pop([[maybe_unused]] const int tid = 0)
+    {
+#ifdef CAUTIOUS_DEQUEUE //checks if the queue is empty before trying operations
+        if (Base::isEmpty()) return nullptr;
+#endif
+        while (true)
+        {
+            Base::safeCluster();
+            uint64_t headTicket = Base::head.fetch_add(1);
+
+            T *item = dequeueTicket(headTicket);
+            if (item != nullptr) {
+                notFull.notify();    //a load if no producer is parked
+                return item;
+            }
+
+            if (Base::tailIndex(Base::tail.load()) <= headTicket)
+            {
+                Base::fixState();
+                return nullptr; // coda vuota;
+            }
+        }
+    }
+
+    /*
+        Blocking push of the bounded queue (backpressure): spins briefly, then parks
+        until a pop frees a cell (or until the timeout, default: no timeout)
+        return: false on timeout
+    */
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    bool pushWait(T *item, const int tid = 0, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) requires bounded {
+        return waitUntil(notFull,waitDeadline(timeout),[this,item,tid](){ return push(item,tid); });
+    }
+
+    /*
+        Blocking pop of the bounded queue: spins briefly, then parks until a push
+        (or until the timeout, default: no timeout)
+        return: nullptr on timeout
+    */
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    T* popWait(const int tid = 0, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) requires bounded {
+        return waitUntil(notEmpty,waitDeadline(timeout),[this,tid](){ return pop(tid); });
+    }
+
+    inline size_t length([[maybe_unused]] const int tid = 0) const {
+        if constexpr (bounded){
+            const int64_t length = static_cast<int64_t>(Base::tail.load() - Base::head.load());
+            return length < 0 ? 0 : static_cast<size_t>(length) > size ? size : length;
+        } else {
+            return Base::length();
+        }
+    }
+
+    template<class, class, template<typename> class> friend class LinkedRingQueue;   //LinkedRingQueue can access private class members
+};
+
+/*
+    Declare aliases for Unbounded and Bounded Queues
+*/
+template<typename T>
+using LCompactCRQueue = LinkedRingQueue<T,CompactCRQueue<T,false>>;
+
+template<typename T>
+using BoundedCompactCRQueue = CompactCRQueue<T,true>;
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include "ReclaimStats.hpp"
+#include "ThreadHandle.hpp"
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#ifndef EBR_ADVANCE_THRESHOLD   //retired pointers per thread between two attempts to advance the epoch
+#define EBR_ADVANCE_THRESHOLD 8
+#endif
+
+/*
+    Epoch Based Reclamation policy (same interface as HazardPointers).
+
+    A thread announces the global epoch on its first protect of an operation
+    and withdraws the announcement when it has cleared all its protections:
+    every operation costs one announce instead of a store (and a re-validation)
+    per protected pointer.
+    Retired pointers are kept in 3 limbo bags indexed by the epoch of retirement;
+    a bag is reclaimed (as a batch) once the global epoch is 2 epochs ahead,
+    i.e. when every active thread has observed the unlink.
+    The epoch advances only when all the active threads announced the current one.
+*/
+template<typename T>
+class EpochBasedReclamation {
+public:
+    static const int MAX_THREADS = 256;     //default number of thread slots
+    static constexpr bool needsValidation = false;  //pointers read during an announced epoch stay valid
+
+private:
+    static const int BAGS = 3;
+    static const int MAX_PROTECTED = 32;    //protection indexes tracked in the held mask
+
+    struct alignas(CACHE_LINE) Record {
+        std::atomic<uint64_t> announce{0};  //(epoch << 1) | 1 if active, 0 if quiescent
+        std::atomic<bool> active{false};    //slot in use by a thread
+        uint32_t held = 0;                  //protection indexes currently in use by the thread
+        size_t retiredSinceAdvance = 0;
+        uint64_t bagEpoch[BAGS] = {};
+        std::vector<T*> bags[BAGS];
+    };
+
+    const int maxThreads;
+
+    //called on retired pointers that are no more reachable (default: delete)
+    const std::function<void(T*)> reclaim;
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> globalEpoch{0};
+    std::unique_ptr<Record[]> records;  //one record per thread slot (allocated at runtime)
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> advanceCount{0};
+    std::atomic<uint64_t> advanceTime{0};
+    std::atomic<uint64_t> reclaimedCount{0};
+
+    inline void enter(Record& rec){
+        if(rec.held == 0)
+            rec.announce.store((globalEpoch.load() << 1) | 1);    //seq_cst: visible before reading the protected pointers
+    }
+
+    inline void leave(Record& rec){
+        if(rec.held == 0)
+            rec.announce.store(0,std::memory_order_release);
+    }
+
+    //reclaims the bags retired at least 2 epochs before the given one
+    void freeBags(Record& rec, const uint64_t epoch){
+        for(int iBag = 0; iBag < BAGS; iBag++){
+            if(rec.bagEpoch[iBag] + 2 > epoch || rec.bags[iBag].empty())
+                continue;
+            for(T* ptr : rec.bags[iBag])
+                reclaim(ptr);
+            reclaimedCount.fetch_add(rec.bags[iBag].size(),std::memory_order_relaxed);
+            rec.bags[iBag].clear();
+        }
+    }
+
+    //advances the global epoch if every active thread announced the current one
+    bool tryAdvance(const uint64_t epoch){
+        using namespace std::chrono;
+        const auto start = steady_clock::now();
+        bool advanced = true;
+        for(int iThread = 0; iThread < maxThreads && advanced; iThread++){
+            const uint64_t a = records[iThread].announce.load();
+            if((a & 1) != 0 && (a >> 1) != epoch)
+                advanced = false;
+        }
+        uint64_t expected = epoch;
+        if(advanced && !globalEpoch.compare_exchange_strong(expected,epoch + 1))
+            advanced = expected > epoch;    //someone else advanced it
+
+        advanceCount.fetch_add(1,std::memory_order_relaxed);
+        advanceTime.fetch_add(duration_cast<nanoseconds>(steady_clock::now() - start).count(),std::memory_order_relaxed);
+        return advanced;
+    }
+
+public:
+    EpochBasedReclamation(  [[maybe_unused]] int maxHPs = MAX_PROTECTED,
+                            int maxThreads = MAX_THREADS,
+                            std::function<void(T*)> reclaim = [](T* ptr){ delete ptr; }):
+    maxThreads{maxThreads},
+    reclaim{std::move(reclaim)},
+    records{new Record[maxThreads]}
+    {
+        assert(maxHPs <= MAX_PROTECTED);
+        assert(maxThreads > 0);
+    }
+
+    ~EpochBasedReclamation(){
+        for(int iThread = 0; iThread < maxThreads; iThread++){
+            for(int iBag = 0; iBag < BAGS; iBag++){
+                for(T* ptr : records[iThread].bags[iBag])
+                    delete ptr;
+            }
+        }
+    }
+
+    //thread slot: index and cached pointer to the thread's record
+    struct Slot {
+        int tid;
+        Record* rec;
+    };
+
+    //fixed slot (legacy int tid API): claimed on first use
+    inline Slot slot(const int tid){
+        assert(tid >= 0 && tid < maxThreads);
+        Record& rec = records[tid];
+        useSlot(rec);
+        return Slot{tid,&rec};
+    }
+
+    //registers the calling thread on a free slot
+    Slot acquire(){
+        const int tid = claimSlot([this](int i) -> Record& { return records[i]; },maxThreads);
+        return Slot{tid,&records[tid]};
+    }
+
+    //the slot can be reused by another thread, its limbo bags are inherited
+    void release(const Slot& s){
+        clear(s);
+        s.rec->active.store(false,std::memory_order_release);
+    }
+
+    void clear(const Slot& s){
+        s.rec->held = 0;
+        leave(*s.rec);
+    }
+
+    void clear(const int index, const Slot& s){
+        s.rec->held &= ~(1u << index);
+        leave(*s.rec);
+    }
+
+    T* protect(const int index, const std::atomic<T*>& atom, const Slot& s){
+        enter(*s.rec);
+        s.rec->held |= (1u << index);
+        return atom.load();
+    }
+
+    T* protect(const int index, T* ptr, const Slot& s){
+        enter(*s.rec);
+        s.rec->held |= (1u << index);
+        return ptr;
+    }
+
+    T* protectRelease(const int index, T* ptr, const Slot& s){
+        return protect(index,ptr,s);
+    }
+
+    void retire(T* ptr, const Slot& s){
+        Record& rec = *s.rec;
+        const uint64_t epoch = globalEpoch.load();
+        freeBags(rec,epoch);
+
+        const int iBag = epoch % BAGS;
+        rec.bagEpoch[iBag] = epoch;     //the bag is empty if it belonged to an older epoch
+        rec.bags[iBag].push_back(ptr);
+
+        if(++rec.retiredSinceAdvance < EBR_ADVANCE_THRESHOLD)
+            return;
+        rec.retiredSinceAdvance = 0;
+        if(tryAdvance(epoch))
+            freeBags(rec,epoch + 1);
+    }
+
+    inline int getMaxThreads() const {
+        return maxThreads;
+    }
+
+    ReclaimStats getStats() const {
+        return ReclaimStats{advanceCount.load(), advanceTime.load(), reclaimedCount.load()};
+    }
+
+    static std::string className(){
+        return "/EBR";
+    }
+};
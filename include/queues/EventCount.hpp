@@ -0,0 +1,201 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <climits>
+#include <bit>
+#include <cassert>
+#include <mutex>
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#ifndef WAIT_SPIN   //failed attempts before a waiting thread parks on the futex
+#define WAIT_SPIN 128
+#endif
+
+namespace detail{
+
+/*
+    Asymmetric barrier: the light side (on the fast path) is a compiler barrier, the
+    heavy side makes every running thread of the process execute a full barrier
+    (membarrier, or the TLB shootdown of mprotect where membarrier is not available).
+    A store followed by a load on both sides can't be reordered on both sides at once.
+*/
+inline void asymmetricLightBarrier() {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+inline bool registerMembarrier() {
+    const long commands = syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+    return commands > 0 && (commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED) != 0 &&
+           syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+}
+
+//changing the protection of a page mapped in the process interrupts the cpus running its threads
+inline void mprotectBarrier() {
+    static const size_t pageSize = sysconf(_SC_PAGESIZE);
+    static void* const page = [](){
+        void* p = mmap(nullptr, pageSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        assert(p != MAP_FAILED);
+        mlock(p, pageSize);
+        return p;
+    }();
+    static std::mutex lock;
+
+    std::lock_guard<std::mutex> guard(lock);
+    mprotect(page, pageSize, PROT_READ | PROT_WRITE);
+    static_cast<std::atomic<int>*>(page)->fetch_add(1);    //the page must be present in the TLBs
+    mprotect(page, pageSize, PROT_READ);
+}
+
+inline void asymmetricHeavyBarrier() {
+    static const bool membarrier = registerMembarrier();
+    if(!membarrier || syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) != 0)
+        mprotectBarrier();
+}
+
+}
+
+/*
+    Event count (futex based) to park the threads waiting for a queue state
+    (not empty / not full).
+
+    The state word holds the epoch (32 MSB) and the number of registered waiters (32 LSB).
+    A waiter registers (prepareWait), re-checks the queue and then sleeps on the epoch
+    until it changes; the notifier bumps the epoch and issues the futex wake only if
+    some thread is registered: without waiters notify() is a single load.
+
+    notify() must follow a seq_cst operation publishing the new state (the queues
+    push/pop with seq_cst RMW) or, if the state is published by a plain store, the
+    light side of the asymmetric barrier (detail::asymmetricLightBarrier).
+    The waiter registers with a seq_cst RMW and issues the heavy side before its re-check
+    (waitUntil): either the notifier sees the waiter or the waiter's re-check sees the new state.
+*/
+class EventCount {
+private:
+    static constexpr uint64_t WAITER      = 1;
+    static constexpr uint64_t WAITER_MASK = (1ull << 32) - 1;
+    static constexpr uint64_t EPOCH       = 1ull << 32;
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> state{0};
+
+    static_assert(std::endian::native == std::endian::little, "EventCount: the futex word is the upper half of the state");
+
+    inline uint32_t* epochWord() {
+        return reinterpret_cast<uint32_t*>(&state) + 1;
+    }
+
+    inline void wake(int count) {
+        state.fetch_add(EPOCH);
+        syscall(SYS_futex, epochWord(), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+    }
+
+public:
+    struct Key {
+        uint32_t epoch;
+    };
+
+    EventCount() = default;
+    EventCount(const EventCount&) = delete;
+    EventCount& operator=(const EventCount&) = delete;
+
+    //registers the calling thread as waiter, then the condition must be checked again
+    inline Key prepareWait() {
+        return Key{static_cast<uint32_t>(state.fetch_add(WAITER) >> 32)};
+    }
+
+    //the condition became true after prepareWait
+    inline void cancelWait() {
+        state.fetch_sub(WAITER);
+    }
+
+    /*
+        Sleeps until a notify after prepareWait or until the deadline
+        return: false on timeout
+    */
+    template<class Clock, class Duration>
+    bool wait(const Key key, const std::chrono::time_point<Clock,Duration> deadline) {
+        using namespace std::chrono;
+        bool notified = true;
+        while((state.load() >> 32) == key.epoch){
+            if(deadline == time_point<Clock,Duration>::max()){
+                syscall(SYS_futex, epochWord(), FUTEX_WAIT_PRIVATE, key.epoch, nullptr, nullptr, 0);
+                continue;
+            }
+            const auto left = deadline - Clock::now();
+            if(left <= Duration::zero()){
+                notified = false;
+                break;
+            }
+            const auto ns = duration_cast<nanoseconds>(left).count();
+            const timespec ts{static_cast<time_t>(ns / 1'000'000'000), static_cast<long>(ns % 1'000'000'000)};
+            syscall(SYS_futex, epochWord(), FUTEX_WAIT_PRIVATE, key.epoch, &ts, nullptr, 0);
+        }
+        state.fetch_sub(WAITER);
+        return notified;
+    }
+
+    //wakes one waiter (if any)
+    inline void notify() {
+        if((state.load() & WAITER_MASK) != 0)
+            wake(1);
+    }
+
+    //wakes all the waiters (if any)
+    inline void notifyAll() {
+        if((state.load() & WAITER_MASK) != 0)
+            wake(INT_MAX);
+    }
+
+    inline bool hasWaiters() const {
+        return (state.load(std::memory_order_relaxed) & WAITER_MASK) != 0;
+    }
+};
+
+//event count of the queues that never block (e.g. segments of a LinkedRingQueue)
+struct NoEventCount {
+    inline void notify() {}
+    inline void notifyAll() {}
+};
+
+/*
+    Spins WAIT_SPIN times on attempt(), then parks on the event count between attempts.
+    attempt() returns a value convertible to bool (the item popped, the push outcome, ...).
+    return: the last result of attempt() (false-like on timeout)
+*/
+template<class Attempt>
+inline auto waitUntil(EventCount& event, const std::chrono::steady_clock::time_point deadline, Attempt&& attempt) {
+    for(int iSpin = 0; iSpin < WAIT_SPIN; iSpin++){
+        auto result = attempt();
+        if(result)
+            return result;
+    }
+    while(true){
+        const EventCount::Key key = event.prepareWait();
+        detail::asymmetricHeavyBarrier();   //notifiers publishing with a plain store see the registration
+        auto result = attempt();
+        if(result){
+            event.cancelWait();
+            return result;
+        }
+        if(!event.wait(key,deadline))
+            return attempt();   //last attempt after the timeout
+    }
+}
+
+//deadline of a wait with the given timeout (max: no timeout)
+template<class Rep, class Period>
+inline std::chrono::steady_clock::time_point waitDeadline(const std::chrono::duration<Rep,Period> timeout) {
+    using namespace std::chrono;
+    if(timeout >= duration_cast<duration<Rep,Period>>(steady_clock::time_point::max() - steady_clock::now()))
+        return steady_clock::time_point::max();
+    return steady_clock::now() + duration_cast<steady_clock::duration>(timeout);
+}
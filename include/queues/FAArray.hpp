@@ -3,50 +3,75 @@
 #include <cmath>
 #include <cstring>
 #include <cstddef>  //for alignas
+#include <memory>
 #include "RQCell.hpp"
-#include "HazardPointers.hpp"
+#include "Reclaimers.hpp"
+#include "SegmentPool.hpp"
+#include "EventCount.hpp"
+#include "NumaAllocator.hpp"
 
 #ifndef CACHE_LINE
 #define CACHE_LINE 64
 #endif
 
-template<typename T, bool padded_cells>
+/*
+    Reclaimer: memory reclamation policy for the retired nodes (see Reclaimers.hpp)
+    remapped_cells: consecutive indices of a node on different cache lines (see detail::CellRemap)
+*/
+template<typename T, bool padded_cells, template<typename> class Reclaimer = DefaultReclaimer, bool remapped_cells = false>
 class FAAArrayQueue {
 private:
-
     struct Node;
+
+public:
+    using Domain = Reclaimer<Node>;     //reclamation domain, private to the queue or shared (see makeDomain)
+
+private:
     using Cell = detail::PlainCell<T*,padded_cells>;
     const size_t maxThreads;
 
-    HazardPointers<Node> HP;
+    SegmentPool<Node> pool;     //retired nodes ready to be reused (declared before HP: HP hands nodes over to it)
+    std::shared_ptr<Domain> domain;
+    Domain& HP;
+    using Slot = typename Reclaimer<Node>::Slot;
     const int kHpTail = 0;
     const int kHpHead = 1;
     const size_t size;
+    const detail::CellRemap<Cell,remapped_cells> remap;
 
     alignas(CACHE_LINE) std::atomic<Node*> head;
     alignas(CACHE_LINE) std::atomic<Node*> tail;
+    EventCount notEmpty;    //consumers parked by popWait
     T* taken = (T*)new int(); //alloca un puntatore a intero e lo casta a T
 
-    struct Node {
+    //the cells follow the node in the same block: allocated with new (detail::RingCells{size}) Node(...)
+    struct Node : detail::SingleBlock<Cell,CACHE_LINE> {
 
         alignas(CACHE_LINE) std::atomic<int>    deqidx;
         alignas(CACHE_LINE) std::atomic<int>    enqidx;
         alignas(CACHE_LINE) std::atomic<Node*>  next;
-        Cell *items;
-        const uint64_t startIndexOffset;
+        uint64_t startIndexOffset;
+        uint64_t birthEra = 0;      //allocation / retirement eras (used by IntervalBasedReclamation)
+        uint64_t retireEra = 0;
 
-        //Inizia con la prima entry prefilled e enqidx a 1
-        Node(T* item, uint64_t startIndexOffset,size_t Buffer_Size=128):
-        deqidx{0}, enqidx{1},
-        next{nullptr}, startIndexOffset(startIndexOffset)
+        //Inizia con la prima entry prefilled e enqidx a 1 (the remapped position of 0 is 0)
+        Node(T* item, uint64_t startIndexOffset,size_t Buffer_Size=128)
         {
-            items = new Cell[Buffer_Size];
-            std::memset(items,0,sizeof(Cell) * Buffer_Size);
-            items[0].val.store(item,std::memory_order_relaxed);
+            init(item,startIndexOffset,Buffer_Size);
         }
 
-        ~Node(){
-            delete[] items;
+        inline Cell* items() const {
+            return detail::trailingCells<Cell>(this);
+        }
+
+        //(Re)initializes the node, used to recycle nodes coming from the pool
+        void init(T* item, uint64_t start, size_t Buffer_Size) {
+            std::memset(static_cast<void*>(items()),0,sizeof(Cell) * Buffer_Size);
+            items()[0].val.store(item,std::memory_order_relaxed);
+            deqidx.store(0,std::memory_order_relaxed);
+            enqidx.store(1,std::memory_order_relaxed);
+            next.store(nullptr,std::memory_order_relaxed);
+            startIndexOffset = start;
         }
 
         inline bool casNext(Node *cmp, Node *val) {
@@ -62,57 +87,96 @@ private:
         return head.compare_exchange_strong(cmp,val);
     }
 
+    //takes a node from the pool if available, otherwise allocates it
+    inline Node* allocNode(T* item, uint64_t start, const Slot& slot) {
+        Node* node = pool.get();
+        if(node == nullptr)
+            node = new (detail::RingCells{size}) Node(item,start,size);
+        else
+            node->init(item,start,size);
+        if constexpr (requires{ HP.onAlloc(node,slot); })
+            HP.onAlloc(node,slot);
+        return node;
+    }
+
 public:
     FAAArrayQueue(size_t Buffer_Size, size_t maxThreads):
-    maxThreads{maxThreads},size{Buffer_Size},
-    HP(2,maxThreads)
+    maxThreads{maxThreads},
+    domain{std::make_shared<Domain>(2,maxThreads,[this](Node* node){ pool.put(node); })},
+    HP{*domain},
+    size{Buffer_Size},remap{Buffer_Size}
     {
         assert(Buffer_Size > 0);
-        Node* sentinelNode = new Node(nullptr,0,Buffer_Size);
+        Node* sentinelNode = new (detail::RingCells{Buffer_Size}) Node(nullptr,0,Buffer_Size);
         sentinelNode->enqidx.store(0,std::memory_order_relaxed);
         head.store(sentinelNode, std::memory_order_relaxed);
         tail.store(sentinelNode, std::memory_order_relaxed);
     }
 
+    //queue attached to a shared reclamation domain (see LinkedRingQueue): reclaimed nodes are deleted
+    FAAArrayQueue(size_t Buffer_Size, std::shared_ptr<Domain> sharedDomain):
+    maxThreads{static_cast<size_t>(sharedDomain->getMaxThreads())},
+    domain{std::move(sharedDomain)},
+    HP{*domain},
+    size{Buffer_Size},remap{Buffer_Size}
+    {
+        assert(Buffer_Size > 0);
+        Node* sentinelNode = new (detail::RingCells{Buffer_Size}) Node(nullptr,0,Buffer_Size);
+        sentinelNode->enqidx.store(0,std::memory_order_relaxed);
+        head.store(sentinelNode, std::memory_order_relaxed);
+        tail.store(sentinelNode, std::memory_order_relaxed);
+    }
+
+    static std::shared_ptr<Domain> makeDomain(size_t threads) {
+        return std::make_shared<Domain>(2,threads);
+    }
+
+    //deletes the linked nodes without using a thread slot (the domain may be shared)
     ~FAAArrayQueue() {
-        while(pop(0) != nullptr);
-        delete head.load(); //elimina l'ultimo nodo
+        Node* node = head.load();
+        while(node != nullptr){
+            Node* next = node->next.load();
+            delete node;
+            node = next;
+        }
         delete (int*)taken;
     }
 
     static std::string className(bool padding = true) {
         using namespace std::string_literals;
-        return "FAAArrayQueue"s + ((padded_cells && padding)? "/padded" : "");
+        return "FAAArrayQueue"s + ((padded_cells && padding)? "/padded" : "") + (remapped_cells? "/remapped" : "") + Reclaimer<Node>::className();
     }
 
-    size_t length(int tid) {
-        Node* lhead = HP.protect(kHpHead,head,tid);
-        Node* ltail = HP.protect(kHpTail,tail,tid);
+private:
+    size_t lengthImpl(const Slot& slot) {
+        Node* lhead = HP.protect(kHpHead,head,slot);
+        Node* ltail = HP.protect(kHpTail,tail,slot);
 
         uint64_t t = std::min((uint64_t) size, ((uint64_t) ltail->enqidx.load())) + ltail->startIndexOffset;
         uint64_t h = std::min((uint64_t) size, ((uint64_t) lhead->deqidx.load())) + lhead->startIndexOffset;
-        HP.clear(tid);
+        HP.clear(slot);
         return t > h ? t - h : 0;
     }
 
-    __attribute__((used,always_inline)) void push(T* item, const int tid) {
+    __attribute__((always_inline)) void pushImpl(T* item, const Slot& slot) {
         if(item == nullptr)
             throw std::invalid_argument("item cannot be null pointer");
 
         while(1){
-            Node *ltail = HP.protect(kHpTail,tail,tid);
+            Node *ltail = HP.protect(kHpTail,tail,slot);
             const int idx = ltail->enqidx.fetch_add(1);
             if(idx >(size-1)) { 
                 if(ltail != tail.load()) continue;
                 Node* lnext = ltail->next.load(); 
                 if(lnext == nullptr) {
-                    Node* newNode = new Node(item,ltail->startIndexOffset + size, size);
+                    Node* newNode = allocNode(item,ltail->startIndexOffset + size,slot);
                     if(ltail->casNext(nullptr,newNode)) {
                         casTail(ltail, newNode);
-                        HP.clear(kHpTail,tid);
+                        HP.clear(kHpTail,slot);
+                        notEmpty.notify();
                         return;
                     }
-                    delete newNode;
+                    pool.put(newNode);
                 } else {
                     casTail(ltail,lnext);
                 }
@@ -120,20 +184,23 @@ public:
             }
 
             T* itemNull = nullptr;
-            if(ltail->items[idx].val.compare_exchange_strong(itemNull,item)) {
-                HP.clear(kHpTail,tid);
+            if(ltail->items()[remap(idx)].val.compare_exchange_strong(itemNull,item)) {
+                HP.clear(kHpTail,slot);
+                notEmpty.notify();  //a load if no consumer is parked
                 return;
             }
         }
     }
 
-    __attribute__((used,always_inline)) T* pop(const int tid) {
+    __attribute__((always_inline)) T* popImpl(const Slot& slot) {
         T* item = nullptr;
-        Node* lhead = HP.protect(kHpHead, head, tid);
+        Node* lhead = HP.protect(kHpHead, head, slot);
 
 #ifdef CAUTIOUS_DEQUEUE
-        if (lhead->deqidx.load() >= lhead->enqidx.load() && lhead->next.load() == nullptr)
+        if (lhead->deqidx.load() >= lhead->enqidx.load() && lhead->next.load() == nullptr) {
+            HP.clear(kHpHead, slot);
             return nullptr;
+        }
 #endif
 
         while (true) {
@@ -144,12 +211,12 @@ public:
                     break;  // No more nodes in the queue
                 }
                 if (casHead(lhead, lnext))
-                    HP.retire(lhead, tid);
+                    HP.retire(lhead, slot);
 
-                lhead = HP.protect(kHpHead, head, tid);
+                lhead = HP.protect(kHpHead, head, slot);
                 continue;
             }
-            Cell& cell = lhead->items[idx];
+            Cell& cell = lhead->items()[remap(idx)];
             if (cell.val.load() == nullptr && idx < lhead->enqidx.load()) {
                 for (size_t i = 0; i < 4*1024; ++i) {
                     if (cell.val.load() != nullptr)
@@ -168,10 +235,78 @@ public:
                 break;
             }
         }
-        HP.clear(kHpHead, tid);
+        HP.clear(kHpHead, slot);
         return item;
     }
 
+    template<class Rep, class Period>
+    T* popWaitImpl(const Slot& slot, const std::chrono::duration<Rep,Period> timeout) {
+        return waitUntil(notEmpty,waitDeadline(timeout),[this,&slot](){ return popImpl(slot); });
+    }
+
+public:
+    //RAII registration on a free thread slot (see LinkedRingQueue::registerThread)
+    using Handle = ThreadHandle<Reclaimer<Node>>;
+
+    Handle registerThread() {
+        return Handle(HP);
+    }
+
+    static Handle registerThread(Domain& sharedDomain) {
+        return Handle(sharedDomain);
+    }
+
+    size_t length(int tid) {
+        return lengthImpl(HP.slot(tid));
+    }
+
+    __attribute__((used,always_inline)) void push(T* item, const int tid) {
+        pushImpl(item,HP.slot(tid));
+    }
+
+    __attribute__((used,always_inline)) T* pop(const int tid) {
+        return popImpl(HP.slot(tid));
+    }
+
+    //blocking pop (see LinkedRingQueue::popWait), nullptr on timeout
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    T* popWait(const int tid, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) {
+        return popWaitImpl(HP.slot(tid),timeout);
+    }
+
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    inline T* popWait(const Handle& h, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) {
+        return popWaitImpl(h.get(),timeout);
+    }
+
+    inline size_t length(const Handle& h) {
+        return lengthImpl(h.get());
+    }
+
+    inline void push(T* item, const Handle& h) {
+        pushImpl(item,h.get());
+    }
+
+    inline T* pop(const Handle& h) {
+        return popImpl(h.get());
+    }
+
+    //runs stall() while holding the protection on the head node (stalled consumer, see MemoryBenchmark)
+    template<typename F>
+    void stalledPop(const int tid, F&& stall) {
+        const Slot slot = HP.slot(tid);
+        HP.protect(kHpHead, head, slot);
+        stall();
+        HP.clear(kHpHead, slot);
+    }
+
+    //node pool statistics (allocations served by the pool / by the allocator)
+    inline uint64_t getPoolHits() const { return pool.getHits(); }
+    inline uint64_t getPoolMisses() const { return pool.getMisses(); }
+
+    //hazard pointers scan statistics
+    inline ReclaimStats getReclaimStats() const { return HP.getStats(); }
+
 };
 
 // Type alias for FAAQueue
@@ -181,3 +316,29 @@ template<typename T, bool padding=true>
 template<typename T, bool padding=false>
 #endif
 using FAAQueue = FAAArrayQueue<T,padding>;
+
+//Same queue with Epoch Based / Interval Based Reclamation, without reclamation of the nodes (see Reclaimers.hpp)
+#ifndef NO_PADDING
+template<typename T, bool padding=true>
+#else
+template<typename T, bool padding=false>
+#endif
+using FAAQueueEBR = FAAArrayQueue<T,padding,EpochBasedReclamation>;
+
+#ifndef NO_PADDING
+template<typename T, bool padding=true>
+#else
+template<typename T, bool padding=false>
+#endif
+using FAAQueueNoReclaim = FAAArrayQueue<T,padding,NoReclamation>;
+
+#ifndef NO_PADDING
+template<typename T, bool padding=true>
+#else
+template<typename T, bool padding=false>
+#endif
+using FAAQueueIBR = FAAArrayQueue<T,padding,IntervalBasedReclamation>;
+
+//Unpadded cells with the cache line remapping of the indices (see detail::CellRemap)
+template<typename T>
+using FAAQueueRemap = FAAArrayQueue<T,false,DefaultReclaimer,true>;
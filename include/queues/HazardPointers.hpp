@@ -4,11 +4,21 @@
 #include <iostream>
 #include <vector>
 #include <cassert>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <new>
+#include <cstddef>
+#include "ReclaimStats.hpp"
+#include "ThreadHandle.hpp"
 
 
 using namespace std;
 
-#ifndef DISABLE_HAZARD
+#ifndef HP_SCAN_FACTOR  //retired pointers per thread before a scan: HP_SCAN_FACTOR * maxThreads * maxHPs
+#define HP_SCAN_FACTOR 2
+#endif
 
 #ifndef CACHE_LINE
 #define CACHE_LINE 64
@@ -17,134 +27,211 @@ using namespace std;
 template<typename T>
 class HazardPointers {
 public:
-    static const int MAX_THREADS        = 256; 
+    static const int MAX_THREADS        = 256;  //default number of thread slots
+    static constexpr bool needsValidation = true;  //protected pointers must be re-validated against the source
 private:
-    static const int MAX_HP_PER_THREAD  = 11;
-    static const int CLPAD     = CACHE_LINE / sizeof(std::atomic<T*>);
-    static const int THRESHOLD_R        = 0;
-    static const int MAX_RETIRED        = MAX_THREADS * MAX_HP_PER_THREAD;
+    static const int DEFAULT_HP_PER_THREAD = 11;
+
+    /*
+        Per thread block, the hazard pointers (maxHPs, sized at runtime) follow the header
+        in the same block. Blocks are padded to a multiple of the cache line
+        (no false sharing between threads): with few hazard pointers a thread takes a single line
+    */
+    struct Record {
+        std::vector<T*> retired;
+        std::atomic<bool> active{false};
+
+        inline std::atomic<T*>* hazards() {
+            return reinterpret_cast<std::atomic<T*>*>(this + 1);
+        }
+    };
+
+    static_assert(sizeof(Record) % alignof(std::atomic<T*>) == 0);
 
     const int maxHPs;
     const int maxThreads;
+    const size_t stride;        //bytes per thread block
+    const size_t thresholdR;    //scan only when the retired list reaches this size
+
+    //called on retired pointers that are no more protected (default: delete)
+    const std::function<void(T*)> reclaim;
+
+    std::byte* storage;     //maxThreads blocks (allocated at runtime, cache line aligned)
+
+    inline Record& record(const int tid) const {
+        return *reinterpret_cast<Record*>(storage + tid * stride);
+    }
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> scanCount{0};
+    std::atomic<uint64_t> scanTime{0};
+    std::atomic<uint64_t> reclaimedCount{0};
+
+    /*
+        Takes a snapshot of the hazard pointers of the registered threads (sorted),
+        then reclaims every retired pointer that is not in the snapshot.
+        The retired list is compacted in place
+    */
+    void scan(Record& rec){
+        using namespace std::chrono;
+        const auto start = steady_clock::now();
+
+        static thread_local std::vector<T*> hazards;    //buffer shared by all the instances used by the thread
+        hazards.clear();
+        for(int iThread = 0; iThread < maxThreads; iThread++){
+            Record& other = record(iThread);
+            if(!other.active.load())
+                continue;   //unused slot
+            for(int iHP = 0; iHP < maxHPs; iHP++){
+                T* ptr = other.hazards()[iHP].load();
+                if(ptr != nullptr)
+                    hazards.push_back(ptr);
+            }
+        }
+        std::sort(hazards.begin(),hazards.end());
+
+        std::vector<T*>& retired = rec.retired;
+        size_t kept = 0;
+        for(size_t iRet = 0; iRet < retired.size(); iRet++){
+            T* obj = retired[iRet];
+            if(std::binary_search(hazards.begin(),hazards.end(),obj))
+                retired[kept++] = obj;  //still protected by someone
+            else
+                reclaim(obj);
+        }
+        const size_t freed = retired.size() - kept;
+        retired.resize(kept);
 
-    //moltiplica per CACHE_LINE (molte celle vuote) ma no false sharing
-    std::atomic<T*> Hazard [MAX_THREADS * CLPAD][MAX_HP_PER_THREAD];
-    std::vector<T*> Retired[MAX_THREADS * CLPAD];
+        scanCount.fetch_add(1,std::memory_order_relaxed);
+        reclaimedCount.fetch_add(freed,std::memory_order_relaxed);
+        scanTime.fetch_add(duration_cast<nanoseconds>(steady_clock::now() - start).count(),std::memory_order_relaxed);
+    }
 
 public:
+    //thread slot: index and cached pointer to the thread's record
+    struct Slot {
+        int tid;
+        Record* rec;
+    };
+
     //constructor
-    HazardPointers(int maxHPs=MAX_HP_PER_THREAD, int maxThreads=MAX_THREADS):
+    HazardPointers(int maxHPs=DEFAULT_HP_PER_THREAD, int maxThreads=MAX_THREADS,
+                   std::function<void(T*)> reclaim = [](T* ptr){ delete ptr; }):
     maxHPs{maxHPs},
-    maxThreads{maxThreads}
+    maxThreads{maxThreads},
+    stride{(sizeof(Record) + maxHPs * sizeof(std::atomic<T*>) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE},
+    thresholdR{static_cast<size_t>(HP_SCAN_FACTOR) * maxThreads * maxHPs},
+    reclaim{std::move(reclaim)},
+    storage{static_cast<std::byte*>(::operator new(stride * maxThreads, std::align_val_t{CACHE_LINE}))}
     {
-        assert(maxHPs <= MAX_HP_PER_THREAD);
-        assert(maxThreads <= MAX_THREADS);
+        assert(maxHPs > 0);
+        assert(maxThreads > 0);
         for(int iThread = 0; iThread < maxThreads; iThread++){
-            for(int iHP = 0; iHP < maxHPs; iHP++){
-                Hazard[iThread*CLPAD][iHP].store(nullptr,std::memory_order_relaxed);
-            }
+            Record* rec = new (storage + iThread * stride) Record();
+            for(int iHP = 0; iHP < maxHPs; iHP++)
+                new (&rec->hazards()[iHP]) std::atomic<T*>(nullptr);
         }
     }
 
+    HazardPointers(const HazardPointers&) = delete;
+    HazardPointers& operator=(const HazardPointers&) = delete;
+
     //destructor
     ~HazardPointers() 
     {
-        for(int iThread = 0; iThread < MAX_THREADS; iThread++){
-            for(unsigned iRet = 0; iRet < Retired[iThread*CLPAD].size(); iRet++){
-                delete Retired[iThread * CLPAD][iRet];
-            }
+        for(int iThread = 0; iThread < maxThreads; iThread++){
+            for(T* ptr : record(iThread).retired)
+                delete ptr;
+            record(iThread).~Record();
         }
+        ::operator delete(storage, std::align_val_t{CACHE_LINE});
+    }
+
+    /**
+     * THREAD SLOTS
+     */
+
+    //fixed slot (legacy int tid API): claimed on first use
+    inline Slot slot(const int tid){
+        assert(tid >= 0 && tid < maxThreads);
+        Record& rec = record(tid);
+        useSlot(rec);
+        return Slot{tid,&rec};
+    }
+
+    //registers the calling thread on a free slot
+    Slot acquire(){
+        const int tid = claimSlot([this](int i) -> Record& { return record(i); },maxThreads);
+        return Slot{tid,&record(tid)};
+    }
+
+    //the slot can be reused by another thread, its retired pointers are inherited
+    void release(const Slot& s){
+        clear(s);
+        if(!s.rec->retired.empty())
+            scan(*s.rec);
+        s.rec->active.store(false,std::memory_order_release);
     }
 
     /**
      * METHODS
      */
 
-    void clear(const int tid){
+    void clear(const Slot& s){
         for(int iHP = 0; iHP < maxHPs; iHP++){
-            Hazard[tid * CLPAD][iHP].store(nullptr,std::memory_order_release);
+            s.rec->hazards()[iHP].store(nullptr,std::memory_order_release);
         }
     }
 
-    void clear(const int iHP, const int tid){
-        Hazard[tid * CLPAD][iHP].store(nullptr,std::memory_order_release);
+    void clear(const int iHP, const Slot& s){
+        s.rec->hazards()[iHP].store(nullptr,std::memory_order_release);
     }
 
     //Atomic pointers
-    T* protect(const int index, const std::atomic<T*>& atom, const int tid){
+    T* protect(const int index, const std::atomic<T*>& atom, const Slot& s){
+        std::atomic<T*>& hazard = s.rec->hazards()[index];
         T* n = nullptr;
         T* ret;
 
         while((ret = atom.load()) != n){
-            Hazard[tid * CLPAD][index].store(ret);
+            hazard.store(ret);
             n = ret;
         }
         return ret;
     }
 
-    T* protect(const int index, T* ptr, const int tid){
-        //cout << "I: "<<tid*CLPAD<< "J: " <<index << endl;
-        Hazard[tid * CLPAD][index].store(ptr);
+    T* protect(const int index, T* ptr, const Slot& s){
+        s.rec->hazards()[index].store(ptr);
         return ptr;
     }
 
-    T* protectRelease(const int index, const T* ptr, const int tid){
-        Hazard[tid*CLPAD][index].store(ptr,std::memory_order_release);
+    T* protectRelease(const int index, T* ptr, const Slot& s){
+        s.rec->hazards()[index].store(ptr,std::memory_order_release);
         return ptr;
     }
 
-    void retire(T* ptr, const int tid) 
+    void retire(T* ptr, const Slot& s) 
     {
-        //cout << "TID "<< tid << "\nPre Size: " << Retired[tid*CLPAD].size() << endl;
-        Retired[tid*CLPAD].push_back(ptr); //push;
-        if(Retired[tid*CLPAD].size() < THRESHOLD_R) //elimina dopo che supera il threshold
+        s.rec->retired.push_back(ptr);
+        if(s.rec->retired.size() < thresholdR) //scan only after the threshold (amortized cost)
             return;
-
-        //cerca di deallocare ogni puntatore nella retiredList
-        for(unsigned iRet = 0; iRet < Retired[tid * CLPAD].size();){
-            auto obj = Retired[tid*CLPAD][iRet];
-
-            bool canDelete = true;
-            //loop in tutta la matrice
-            for(int tid = 0; tid < maxThreads && canDelete; tid++){
-                for(int iHP = maxHPs -1; iHP >= 0; iHP--){
-                    if(Hazard[tid*CLPAD][iHP].load() == obj){
-                        canDelete = false;
-                        break;
-                    }
-                }
-            }
-
-            if(canDelete){
-                Retired[tid*CLPAD].erase(Retired[tid*CLPAD].begin() + iRet);
-                delete obj;
-                continue;
-            }
-            
-            iRet++; //incremento in fondo, perchè se canDelete è true, l'array ha una cella in meno
-        }
-        
-        
+        scan(*s.rec);
     }
 
+    inline int getMaxThreads() const {
+        return maxThreads;
+    }
 
-};
+    //bytes of per thread storage
+    inline size_t footprint() const {
+        return stride * maxThreads;
+    }
 
+    ReclaimStats getStats() const {
+        return ReclaimStats{scanCount.load(), scanTime.load(), reclaimedCount.load()};
+    }
 
-#else //stubs
+    static std::string className(){
+        return "";
+    }
 
-template<typename T>
-class HazardPointers {
-public:
-    HazardPointers( [[maybe_unused]] int maxHPs=0,
-                    [[maybe_unused]] int maxThreads = 0) {}
-
-    void clear(const int){}
-    void clear(const int, const int){}
-    T* protect(const int, std::atomic<T*>& atom,const int){return atom.load();}
-    T* protect(const int, T* ptr, const int){return ptr;}
-    T* protectRelease(const int, T* ptr, const int){return ptr;}
-    void retire(T*, const int){};
 };
-
-#endif //_HAZARD_POINTERS_H_
\ No newline at end of file
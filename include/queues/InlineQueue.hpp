@@ -0,0 +1,234 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>  // For alignas
+#include <concepts>
+#include <stdexcept>
+#include <type_traits>
+
+#include "TemplateSet.hpp"
+#include "LCRQ.hpp"
+#include "LMTQ.hpp"
+#include "RQCell.hpp"
+#include "NumaAllocator.hpp"
+#include "Backoff.hpp"
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+/*
+    Queues carrying trivially copyable values instead of pointers: producers
+    don't allocate the messages and consumers don't follow a pointer to read them.
+
+    InlineQueue<V,Q>:       values of up to 8 bytes stored in the pointer word of
+                            the cells of Q (InlineQueues: CRQueue and MTQueue rings,
+                            bounded or as LinkedRingQueue segments)
+    BoundedValueQueue<V>:   values of any size (e.g. 16 bytes) stored in the cells
+                            of a bounded MTQueue-like ring
+
+    Interface: push(value,tid) (bool if bounded), bool pop(value&,tid), length(tid)
+*/
+
+template<typename V>
+concept InlineValue = std::is_trivially_copyable_v<V> && std::default_initializable<V>;
+
+namespace detail{
+
+//type of the words stored by the inner queue of InlineQueue: never dereferenced
+struct InlineWord;
+
+/*
+    Encoding of a value of at most 8 bytes in a non null word: the bits of the
+    value xor the bits of the empty sentinel, so the sentinel (and only the
+    sentinel) is encoded as nullptr, the empty cell of the inner queue.
+*/
+template<typename V>
+class WordCodec {
+private:
+    uintptr_t sentinel;
+
+    static inline uintptr_t bits(const V& value) {
+        uintptr_t word = 0;
+        std::memcpy(&word,&value,sizeof(V));
+        return word;
+    }
+
+public:
+    explicit WordCodec(const V& empty): sentinel{bits(empty)} {}
+
+    inline InlineWord* encode(const V& value) const {
+        return reinterpret_cast<InlineWord*>(bits(value) ^ sentinel);
+    }
+
+    inline V decode(InlineWord* word) const {
+        const uintptr_t raw = reinterpret_cast<uintptr_t>(word) ^ sentinel;
+        V value;
+        std::memcpy(static_cast<void*>(&value),&raw,sizeof(V));    //V is trivially copyable, not trivial (-Wclass-memaccess)
+        return value;
+    }
+};
+
+}
+
+//Queues that never look at the bits of the stored pointers (besides nullptr):
+//LPRQ marks the bottom values in the low bit, FAAArrayQueue has a taken marker
+using InlineCapableQueues = TemplateSet<LCRQueue,BoundedCRQueue,LMTQueue,BoundedMTQueue,
+                                        LCRQueueRemap,BoundedCRQueueRemap,LMTQueueRemap,BoundedMTQueueRemap>;
+
+/*
+    Values of at most 8 bytes stored in the cells of Q.
+    empty: value reserved as the empty marker, it can't be pushed (default: all bits 0)
+*/
+template<InlineValue V, template<typename> class Q>
+requires (sizeof(V) <= sizeof(void*))
+class InlineQueue {
+private:
+    using Inner = Q<detail::InlineWord>;
+    static_assert(InlineCapableQueues::Contains<Q>,"InlineQueue needs a queue storing opaque pointers (see InlineCapableQueues)");
+
+    Inner queue;
+    const detail::WordCodec<V> codec;
+
+public:
+    InlineQueue(size_t size, size_t threads = 128, const V& empty = V{}):
+    queue(size,threads),
+    codec{empty} {}
+
+    static std::string className(bool padding = true){
+        return "Inline" + Inner::className(padding);
+    }
+
+    __attribute__((used,always_inline)) auto push(const V& value, const int tid) {
+        detail::InlineWord* word = codec.encode(value);
+        if(word == nullptr)
+            throw std::invalid_argument(className(false) + " ERROR push(): the empty sentinel cannot be pushed");
+        return queue.push(word,tid);
+    }
+
+    __attribute__((used,always_inline)) bool pop(V& value, const int tid) {
+        detail::InlineWord* word = queue.pop(tid);
+        if(word == nullptr)
+            return false;
+        value = codec.decode(word);
+        return true;
+    }
+
+    size_t length(const int tid = 0) {
+        return queue.length(tid);
+    }
+};
+
+/*
+    Bounded MPMC ring storing the values in its cells (any trivially copyable V).
+    Same protocol as the bounded MTQueue: a thread owns the cell of the ticket
+    it got with a CAS on tail / head, the sequence number of the cell (ValueCell::idx)
+    marks it empty (ticket) or full (ticket + 1). No empty sentinel is needed.
+*/
+template<InlineValue V, bool padded_cells = true>
+class BoundedValueQueue {
+private:
+    using Cell = detail::ValueCell<V,padded_cells>;
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> head{0};
+    alignas(CACHE_LINE) std::atomic<uint64_t> tail{0};
+    alignas(CACHE_LINE) const size_t size;
+#ifndef DISABLE_POW2
+    const size_t mask;  //Mask to execute the modulo operation
+#endif
+    detail::NumaArray<Cell> array;   //placed following SEGMENT_NUMA_POLICY
+
+    inline Cell& cellAt(uint64_t ticket) const {
+#ifndef DISABLE_POW2
+        return array[ticket & mask];
+#else
+        return array[ticket % size];
+#endif
+    }
+
+public:
+    BoundedValueQueue(size_t size_par, [[maybe_unused]] const int tid = 0):
+#ifndef DISABLE_POW2
+    size{detail::nextPowTwo(size_par)},
+    mask{size - 1},
+#else
+    size{size_par},
+#endif
+    array(size)
+    {
+        if(size_par == 0)
+            throw std::invalid_argument("Ring Size must be greater than 0");
+        for(uint64_t i = 0; i < size; i++)
+            cellAt(i).idx.store(i,std::memory_order_relaxed);
+    }
+
+    static std::string className(bool padding = true){
+        using namespace std::string_literals;
+        return "BoundedValueQueue"s + ((padded_cells && padding)? "/padded":"");
+    }
+
+    //memory taken by every slot of the ring
+    static constexpr size_t bytesPerSlot() {
+        return sizeof(Cell);
+    }
+
+    __attribute__((used,always_inline)) bool push(const V& value, [[maybe_unused]] const int tid = 0) {
+        ExpBackoff backoff;
+        while(true){
+            uint64_t tailTicket = tail.load(std::memory_order_relaxed);
+            Cell& cell = cellAt(tailTicket);
+            const uint64_t idx = cell.idx.load(std::memory_order_acquire);
+            if(idx == tailTicket){
+                if(tail.compare_exchange_strong(tailTicket,tailTicket + 1)){
+                    cell.val = value;
+                    cell.idx.store(tailTicket + 1,std::memory_order_release);
+                    return true;
+                }
+                backoff.wait();
+            } else if(static_cast<int64_t>(idx - tailTicket) < 0)
+                return false;   //the cell still holds the value of the previous round: full
+        }
+    }
+
+    __attribute__((used,always_inline)) bool pop(V& value, [[maybe_unused]] const int tid = 0) {
+        ExpBackoff backoff;
+        while(true){
+            uint64_t headTicket = head.load(std::memory_order_relaxed);
+            Cell& cell = cellAt(headTicket);
+            const uint64_t idx = cell.idx.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(idx - (headTicket + 1));
+            if(diff == 0){
+                if(head.compare_exchange_strong(headTicket,headTicket + 1)){
+                    value = cell.val;
+                    cell.idx.store(headTicket + size,std::memory_order_release);
+                    return true;
+                }
+                backoff.wait();
+            } else if(diff < 0)
+                return false;   //empty
+        }
+    }
+
+    inline size_t length([[maybe_unused]] const int tid = 0) const {
+        const int64_t length = static_cast<int64_t>(tail.load() - head.load());
+        return length < 0 ? 0 : static_cast<size_t>(length) > size ? size : length;
+    }
+};
+
+/*
+    Declare aliases for the inline queues
+*/
+template<typename V>
+using InlineLCRQueue = InlineQueue<V,LCRQueue>;
+
+template<typename V>
+using InlineLMTQueue = InlineQueue<V,LMTQueue>;
+
+template<typename V>
+using InlineBoundedCRQueue = InlineQueue<V,BoundedCRQueue>;
+
+template<typename V>
+using InlineBoundedMTQueue = InlineQueue<V,BoundedMTQueue>;
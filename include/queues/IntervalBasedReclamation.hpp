@@ -0,0 +1,231 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <limits>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include "ReclaimStats.hpp"
+#include "ThreadHandle.hpp"
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#ifndef IBR_ERA_FREQ    //allocations per thread between two era increments
+#define IBR_ERA_FREQ 1
+#endif
+
+#ifndef IBR_SCAN_THRESHOLD  //retired pointers per thread before a scan of the reservations
+#define IBR_SCAN_THRESHOLD 8
+#endif
+
+/*
+    Interval Based Reclamation policy (2GEIBR, same interface as HazardPointers).
+
+    Every object records the era of its allocation (birthEra, set by onAlloc)
+    and of its retirement (retireEra). An active thread reserves the interval
+    of eras [lower, upper]: lower is the era at the start of the operation,
+    upper is extended to the current era on every protect.
+    The era advances every IBR_ERA_FREQ allocations and on every retire.
+    A retired object is reclaimed when its lifetime does not intersect
+    the reservation of any thread: a stalled thread pins only the objects
+    that were alive during its reservation (bounded memory, unlike EBR).
+
+    Objects must expose the birthEra and retireEra fields (see QueueSegmentBase).
+    Like hazard pointers, a protected pointer must be validated against its source.
+*/
+template<typename T>
+class IntervalBasedReclamation {
+public:
+    static const int MAX_THREADS = 256;     //default number of thread slots
+    static constexpr bool needsValidation = true;   //the reservation covers the pointer only if it is still reachable
+
+private:
+    static constexpr uint64_t NONE = std::numeric_limits<uint64_t>::max();
+    static const int MAX_PROTECTED = 32;
+
+    struct alignas(CACHE_LINE) Record {
+        std::atomic<uint64_t> lower{NONE};
+        std::atomic<uint64_t> upper{NONE};
+        std::atomic<bool> active{false};    //slot in use by a thread
+        uint32_t held = 0;                  //protection indexes currently in use by the thread
+        size_t allocCount = 0;
+        std::vector<T*> retired;
+    };
+
+    const int maxThreads;
+
+    //called on retired pointers that are no more reserved (default: delete)
+    const std::function<void(T*)> reclaim;
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> era{1};
+    std::unique_ptr<Record[]> records;  //one record per thread slot (allocated at runtime)
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> scanCount{0};
+    std::atomic<uint64_t> scanTime{0};
+    std::atomic<uint64_t> reclaimedCount{0};
+
+    inline void enter(Record& rec){
+        if(rec.held != 0) return;
+        const uint64_t e = era.load();
+        rec.lower.store(e);
+        rec.upper.store(e);
+    }
+
+    inline void leave(Record& rec){
+        if(rec.held != 0) return;
+        rec.upper.store(NONE,std::memory_order_release);
+        rec.lower.store(NONE,std::memory_order_release);
+    }
+
+    //extends the reservation up to the current era
+    inline void extend(Record& rec){
+        const uint64_t e = era.load();
+        if(rec.upper.load(std::memory_order_relaxed) != e)
+            rec.upper.store(e);
+    }
+
+    //reclaims every retired object whose lifetime does not intersect a reservation
+    void scan(Record& rec){
+        using namespace std::chrono;
+        const auto start = steady_clock::now();
+
+        std::vector<T*>& retired = rec.retired;
+        size_t kept = 0;
+        for(size_t iRet = 0; iRet < retired.size(); iRet++){
+            T* obj = retired[iRet];
+            bool reserved = false;
+            for(int iThread = 0; iThread < maxThreads && !reserved; iThread++){
+                if(!records[iThread].active.load())
+                    continue;   //unused slot
+                const uint64_t lower = records[iThread].lower.load();
+                const uint64_t upper = records[iThread].upper.load();
+                reserved = lower != NONE && obj->birthEra <= upper && obj->retireEra >= lower;
+            }
+            if(reserved)
+                retired[kept++] = obj;
+            else
+                reclaim(obj);
+        }
+        const size_t freed = retired.size() - kept;
+        retired.resize(kept);
+
+        scanCount.fetch_add(1,std::memory_order_relaxed);
+        reclaimedCount.fetch_add(freed,std::memory_order_relaxed);
+        scanTime.fetch_add(duration_cast<nanoseconds>(steady_clock::now() - start).count(),std::memory_order_relaxed);
+    }
+
+public:
+    IntervalBasedReclamation(   [[maybe_unused]] int maxHPs = MAX_PROTECTED,
+                                int maxThreads = MAX_THREADS,
+                                std::function<void(T*)> reclaim = [](T* ptr){ delete ptr; }):
+    maxThreads{maxThreads},
+    reclaim{std::move(reclaim)},
+    records{new Record[maxThreads]}
+    {
+        assert(maxHPs <= MAX_PROTECTED);
+        assert(maxThreads > 0);
+    }
+
+    ~IntervalBasedReclamation(){
+        for(int iThread = 0; iThread < maxThreads; iThread++){
+            for(T* ptr : records[iThread].retired)
+                delete ptr;
+        }
+    }
+
+    //thread slot: index and cached pointer to the thread's record
+    struct Slot {
+        int tid;
+        Record* rec;
+    };
+
+    //fixed slot (legacy int tid API): claimed on first use
+    inline Slot slot(const int tid){
+        assert(tid >= 0 && tid < maxThreads);
+        Record& rec = records[tid];
+        useSlot(rec);
+        return Slot{tid,&rec};
+    }
+
+    //registers the calling thread on a free slot
+    Slot acquire(){
+        const int tid = claimSlot([this](int i) -> Record& { return records[i]; },maxThreads);
+        return Slot{tid,&records[tid]};
+    }
+
+    //the slot can be reused by another thread, its retired pointers are inherited
+    void release(const Slot& s){
+        clear(s);
+        if(!s.rec->retired.empty())
+            scan(*s.rec);
+        s.rec->active.store(false,std::memory_order_release);
+    }
+
+    //stamps the birth era of a new (or recycled) object
+    void onAlloc(T* obj, const Slot& s){
+        obj->birthEra = era.load();
+        if(++s.rec->allocCount >= IBR_ERA_FREQ){
+            s.rec->allocCount = 0;
+            era.fetch_add(1);
+        }
+    }
+
+    void clear(const Slot& s){
+        s.rec->held = 0;
+        leave(*s.rec);
+    }
+
+    void clear(const int index, const Slot& s){
+        s.rec->held &= ~(1u << index);
+        leave(*s.rec);
+    }
+
+    T* protect(const int index, const std::atomic<T*>& atom, const Slot& s){
+        Record& rec = *s.rec;
+        enter(rec);
+        rec.held |= (1u << index);
+        while(true){
+            T* ptr = atom.load();
+            const uint64_t e = era.load();
+            if(rec.upper.load(std::memory_order_relaxed) == e)
+                return ptr;
+            rec.upper.store(e);
+        }
+    }
+
+    T* protect(const int index, T* ptr, const Slot& s){
+        enter(*s.rec);
+        s.rec->held |= (1u << index);
+        extend(*s.rec);
+        return ptr;
+    }
+
+    T* protectRelease(const int index, T* ptr, const Slot& s){
+        return protect(index,ptr,s);
+    }
+
+    void retire(T* ptr, const Slot& s){
+        ptr->retireEra = era.fetch_add(1);  //new operations start after the retirement (even without allocations)
+        s.rec->retired.push_back(ptr);
+        if(s.rec->retired.size() < IBR_SCAN_THRESHOLD)
+            return;
+        scan(*s.rec);
+    }
+
+    inline int getMaxThreads() const {
+        return maxThreads;
+    }
+
+    ReclaimStats getStats() const {
+        return ReclaimStats{scanCount.load(), scanTime.load(), reclaimedCount.load()};
+    }
+
+    static std::string className(){
+        return "/IBR";
+    }
+};
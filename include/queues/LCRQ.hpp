@@ -2,9 +2,12 @@
 
 #include <atomic>
 #include <cassert>
+#include <algorithm>
 
 #include "LinkedRingQueue.hpp"
 #include "RQCell.hpp"
+#include "NumaAllocator.hpp"
+#include "StarvingPush.hpp"
 #include "x86Atomics.hpp"
 #include "numa_support.hpp"
 
@@ -13,66 +16,196 @@ using namespace std;
 /*
     Macros:
     DISABLE_PADDING: disables padding for cells
-    DISABLE_POW2: Disables power of 2 modulo ops
+    DISABLE_POW2: Disables power of 2 modulo ops (runtime ring size only)
     CAUTIOUS_DEQUEUE: check that the queue is empty before attempt pop
+
+    N: ring size fixed at compile time, cells embedded in the segment (0: runtime size, see detail::RingSize)
 */
 
 
-template <typename T, bool padded_cells, bool bounded>
-class CRQueue : public QueueSegmentBase<T, CRQueue<T, padded_cells, bounded>> {
+template <typename T, bool padded_cells, bool bounded, size_t N = 0, bool remapped_cells = false>
+class CRQueue : public QueueSegmentBase<T, CRQueue<T, padded_cells, bounded, N, remapped_cells>>,
+                private detail::RingSize<N>,
+                public detail::SingleBlockIf<!bounded && N == 0, detail::CRQCell<T *, padded_cells>> {
 private:
 
-    using Base = QueueSegmentBase<T, CRQueue<T, padded_cells, bounded>>;
+    using Base = QueueSegmentBase<T, CRQueue<T, padded_cells, bounded, N, remapped_cells>>;
+    using Ring = detail::RingSize<N>;
     using Cell = detail::CRQCell<T *, padded_cells>;
+    //unbounded segments: cells in the same block (allocated by LinkedRingQueue only, see detail::SingleBlock)
+    static constexpr bool singleBlock = detail::useSingleBlock<!bounded && N == 0, Cell>;
+    using Ring::size;
+    using Ring::position;
+    using Ring::cellsFor;
 
-    static constexpr size_t TRY_CLOSE = 10;
+    detail::RingArray<Cell,N,singleBlock> array;   //placed following SEGMENT_NUMA_POLICY (bounded, runtime size)
+    detail::CellRemap<Cell,remapped_cells> remap;   //consecutive tickets on different cache lines (unpadded cells)
 
-    size_t size;
-#ifndef DISABLE_POW2
-    size_t mask;  //Mask to execute the modulo operation
-#endif
-    Cell *array;
+    detail::StarvingPush<T> starving;  //slow path of the producers failing STARVATION_THRESHOLD times
+
+    //consumers parked by popWait (only the bounded queue blocks: segments are woken by LinkedRingQueue)
+    [[no_unique_address]] std::conditional_t<bounded,EventCount,NoEventCount> notEmpty;
+    //producers parked by pushWait (bounded queue only)
+    [[no_unique_address]] std::conditional_t<bounded,EventCount,NoEventCount> notFull;
 
     inline uint64_t nodeIndex(uint64_t i)   const {return (i & ~(1ull << 63));}
     inline uint64_t nodeUnsafe(uint64_t i)  const {return i & (1ull << 63);}
     inline uint64_t setUnsafe(uint64_t i)   const {return (i | (1ull << 63));}
 
+    inline Cell* cells() const {
+        if constexpr (singleBlock) return detail::trailingCells<Cell>(this);
+        else return array.data();
+    }
+
+    inline Cell& cellAt(uint64_t ticket) const {
+        return cells()[remap(position(ticket))];
+    }
+
+    /*
+        Tries to store item in the cell of tailTicket (the ticket is already owned)
+        return: true if the item has been inserted
+    */
+    __attribute__((always_inline)) bool enqueueTicket(const uint64_t tailTicket, T *item)
+    {
+        Cell &cell = cellAt(tailTicket);
+        uint64_t idx = cell.idx.load();
+        if (cell.val.load() == nullptr)
+        {
+            if (nodeIndex(idx) <= tailTicket)
+            {
+                if ((!nodeUnsafe(idx) || Base::head.load() < tailTicket))
+                {
+                    if (CAS2((void **)&cell, nullptr, idx, item, tailTicket))
+                        return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /*
+        Consumes the cell of headTicket (the ticket is already owned)
+        return: the item stored for headTicket or nullptr if the cell has been
+                invalidated (empty or unsafe transition)
+    */
+    __attribute__((always_inline)) T *dequeueTicket(const uint64_t headTicket)
+    {
+        Cell &cell = cellAt(headTicket);
+
+        int r = 0;
+        uint64_t tt = 0;
+
+        while (true)
+        {
+            uint64_t cell_idx = cell.idx.load();
+            uint64_t unsafe = nodeUnsafe(cell_idx);
+            uint64_t idx = nodeIndex(cell_idx);
+            T *val = static_cast<T *>(cell.val.load());
+
+            if (idx > headTicket)
+                return nullptr;
+
+            if (val != nullptr)
+            { //
+                if (idx == headTicket)
+                {
+                    if (CAS2((void **)&cell, val, cell_idx, nullptr, unsafe | (headTicket + size)))
+                        return val;
+                }
+                else
+                { // Unsafe Transition
+                    if (CAS2((void **)&cell, val, cell_idx, val, setUnsafe(idx)))
+                        return nullptr;
+                }
+            }
+            else
+            { // Void Transition
+                if ((r & ((1ull << 8)) - 1) == 0)
+                    tt = Base::tail.load();
+
+                int closed = Base::isClosed(tt);
+                uint64_t t = Base::tailIndex(tt);
+                if (unsafe || t < headTicket + 1 || closed || r > 4 * 1024 )
+                {
+                    if (CAS2((void **)&cell, val, cell_idx, val, unsafe | (headTicket + size)))
+                        return nullptr;
+                }
+                ++r;
+            }
+        }
+    }
+
+    /*
+        Slow path of a producer that failed STARVATION_THRESHOLD tickets (tailTicket is the last one):
+        publishes the item for the consumers finding the ring empty, if nobody takes it
+        the producer takes it back and only then a full segment is closed (BIT_TEST_AND_SET63)
+    */
+    detail::SlowPush slowPush(T *item, const uint64_t tailTicket)
+    {
+        if (starving.publish(item))
+            return detail::SlowPush::Helped;
+        if constexpr (bounded == false){
+            if (tailTicket >= Base::head.load() + size && Base::closeSegment(tailTicket, true)){
+                starving.countForcedClose();
+                return detail::SlowPush::Closed;
+            }
+        }
+        return detail::SlowPush::Retry;
+    }
+
+    //empty ring: takes the item of a starving producer, if any (open segments only)
+    inline T* helpStarving() {
+        if constexpr (bounded == false){
+            if(Base::isClosed(Base::tail.load()))
+                return nullptr;
+        }
+        return starving.help();
+    }
+
 private:
-    CRQueue(size_t size_par,[[maybe_unused]] const int tid, const uint64_t start): Base(), 
-#ifndef DISABLE_POW2
-    size{detail::nextPowTwo(size_par)},
-    mask{size - 1}
-#else
-    size{size_par}
-#endif
+    CRQueue(size_t size_par,[[maybe_unused]] const int tid, const uint64_t start): Base(), Ring(size_par),
+    array(size),
+    remap{size}
     {
         assert(size_par > 0);
-        array = new Cell[size];
+        init(start);
+    }
 
+    /*
+        (Re)initializes the ring to start from the given index: used by the constructor
+        and by LinkedRingQueue to recycle a retired segment without reallocating it
+    */
+    void init(const uint64_t start){
         for(uint64_t i = start; i < start + size; ++i){
-            array[i % size].val.store(nullptr,memory_order_relaxed);
-            array[i % size].idx.store(i,memory_order_relaxed);           
+            cellAt(i).val.store(nullptr,memory_order_relaxed);
+            cellAt(i).idx.store(i,memory_order_relaxed);
         }
 
         Base::head.store(start,memory_order_relaxed);
         Base::tail.store(start,memory_order_relaxed);
+        Base::next.store(nullptr,memory_order_relaxed);
+        starving.reset();
         //Numa optimization
-        Base::cluster.store((isNumaAvailable() ? getNumaNode() : 0), memory_order_relaxed );
+        Base::cohort.reset(Base::clusterNode());
     }
 
 
 public: 
     //uses the tid argument to be consistent with linked queues
-    CRQueue(size_t size_par,[[maybe_unused]] const int tid = 0): CRQueue(size_par,tid,0){}
+    CRQueue(size_t size_par,[[maybe_unused]] const int tid = 0) requires (!singleBlock): CRQueue(size_par,tid,0){}
 
     ~CRQueue() { 
         while(pop(0) != nullptr);
-        delete[] array; 
     }
 
     static std::string className(bool padding = true){
         using namespace std::string_literals;
-        return (bounded? "Bounded"s : ""s) + "CRQueue"s + ((padded_cells && padding)? "/padded":"");
+        return (bounded? "Bounded"s : ""s) + "CRQueue"s + ((padded_cells && padding)? "/padded":"") + (remapped_cells? "/remapped":"") + (N? "/fixed" + std::to_string(N) : "");
+    }
+
+    //memory taken by every slot of the ring
+    static constexpr size_t bytesPerSlot() {
+        return sizeof(Cell);
     }
 
     /*
@@ -82,7 +215,7 @@ public:
     */
     __attribute__((used,always_inline)) bool push(T *item,[[maybe_unused]] const int tid = 0)
     {
-        int try_close = 0;
+        int failures = 0;
 
         while (true)
         {
@@ -94,22 +227,10 @@ public:
                     return false;
                 }
             }
-#ifndef DISABLE_POW2
-            Cell &cell = array[tailTicket & mask];
-#else
-            Cell &cell = array[tailTicket % size];
-#endif
-            uint64_t idx = cell.idx.load();
-            if (cell.val.load() == nullptr)
-            {
-                if (nodeIndex(idx) <= tailTicket)
-                {
-                    if ((!nodeUnsafe(idx) || Base::head.load() < tailTicket))
-                    {
-                        if (CAS2((void **)&cell, nullptr, idx, item, tailTicket))
-                            return true;
-                    }
-                }
+
+            if (enqueueTicket(tailTicket, item)) {
+                notEmpty.notify();   //a load if no consumer is parked
+                return true;
             }
 
             if (tailTicket >= Base::head.load() + size)
@@ -118,14 +239,99 @@ public:
                     return false;
                 }
                 else{
-                    if (Base::closeSegment(tailTicket, ++try_close > TRY_CLOSE)){
+                    if (Base::closeSegment(tailTicket, false)){
                         return false;
                     }
                 }
             }
+
+            //starving: a consumer completes the push, otherwise a full ring is closed
+            if (++failures >= STARVATION_THRESHOLD)
+            {
+                const detail::SlowPush outcome = slowPush(item, tailTicket);
+                if (outcome != detail::SlowPush::Retry)
+                    return outcome == detail::SlowPush::Helped;
+                failures = 0;
+            }
         }
     }
 
+    /*
+        Batched push: reserves a whole range of tickets with a single fetch_add
+        and fills the claimed cells in order.
+        The range is clamped to the free space of the ring, so a batch never
+        reserves tickets that could only fail.
+
+        return: number of items inserted (less than n if the ring is full or
+                the segment has been closed, the caller carries the rest)
+    */
+    size_t pushBatchTickets(T **items, size_t n, [[maybe_unused]] const int tid = 0)
+    {
+        size_t done = 0;
+        int failures = 0;
+
+        while (done < n)
+        {
+            Base::safeCluster();
+            uint64_t tt = Base::tail.load();
+            if constexpr (bounded == false){
+                if(Base::isClosed(tt))
+                    return done;
+            }
+            uint64_t limit = Base::head.load() + size;
+            uint64_t free = (Base::tailIndex(tt) < limit)? limit - Base::tailIndex(tt) : 1;
+            uint64_t want = std::min<uint64_t>(n - done, free);
+
+            uint64_t firstTicket = Base::tail.fetch_add(want);
+            if constexpr (bounded == false){
+                if(Base::isClosed(firstTicket))
+                    return done;
+            }
+
+            for (uint64_t tailTicket = firstTicket; tailTicket < firstTicket + want; ++tailTicket)
+            {
+                if (enqueueTicket(tailTicket, items[done])){
+                    ++done;
+                    failures = 0;
+                    continue;
+                }
+                const bool full = tailTicket >= Base::head.load() + size;
+                if (full)
+                {   //the rest of the range is beyond the ring capacity
+                    if constexpr (bounded){
+                        return done;
+                    }
+                    else{
+                        if (Base::closeSegment(firstTicket + want - 1, false))
+                            return done;
+                    }
+                }
+                //starving on items[done]: same slow path as push, then a new range for the rest
+                if (++failures >= STARVATION_THRESHOLD)
+                {
+                    const detail::SlowPush outcome = slowPush(items[done], tailTicket);
+                    if (outcome == detail::SlowPush::Closed)
+                        return done;
+                    if (outcome == detail::SlowPush::Helped)
+                        ++done;
+                    failures = 0;
+                    break;
+                }
+                if (full)
+                    break;
+            }
+        }
+        return done;
+    }
+
+    //batched push (see pushBatchTickets), wakes the parked consumers of the bounded queue
+    size_t pushBatch(T **items, size_t n, const int tid = 0) {
+        const size_t done = pushBatchTickets(items,n,tid);
+        if(done != 0)
+            notEmpty.notifyAll();
+        return done;
+    }
+
      /*
         Takes an additional tid parameter to keep the interface compatible with
         LinkedRingQueue->pop
@@ -140,87 +346,140 @@ public:
         {
             Base::safeCluster();
             uint64_t headTicket = Base::head.fetch_add(1);
-#ifndef DISABLE_POW2
-            Cell &cell = array[headTicket & mask];
-#else
-            Cell &cell = array[headTicket % size];
-#endif
 
-            int r = 0;
-            uint64_t tt = 0;
+            T *item = dequeueTicket(headTicket);
+            if (item != nullptr) {
+                notFull.notify();    //a load if no producer is parked
+                return item;
+            }
 
-            while (true)
+            if (Base::tailIndex(Base::tail.load()) <= headTicket)
             {
-                uint64_t cell_idx = cell.idx.load();
-                uint64_t unsafe = nodeUnsafe(cell_idx);
-                uint64_t idx = nodeIndex(cell_idx);
-                T *val = static_cast<T *>(cell.val.load());
+                Base::fixState();
+                return helpStarving(); // coda vuota;
+            }
+        }
+    }
 
-                if (idx > headTicket)
-                    break;
+    /*
+        Batched pop: reserves up to max tickets with a single fetch_add (never
+        more than the items currently in the ring) and drains the claimed cells.
 
-                if (val != nullptr)
-                { //
-                    if (idx == headTicket)
-                    {
-                        if (CAS2((void **)&cell, val, cell_idx, nullptr, unsafe | (headTicket + size)))
-                            return val;
-                    }
-                    else
-                    { // Unsafe Transition
-                        if (CAS2((void **)&cell, val, cell_idx, val, setUnsafe(idx)))
-                            break;
-                    }
-                }
-                else
-                { // Void Transition
-                    if ((r & ((1ull << 8)) - 1) == 0)
-                        tt = Base::tail.load();
-
-                    int closed = Base::isClosed(tt);
-                    uint64_t t = Base::tailIndex(tt);
-                    if (unsafe || t < headTicket + 1 || closed || r > 4 * 1024 )
-                    {
-                        if (CAS2((void **)&cell, val, cell_idx, val, unsafe | (headTicket + size)))
-                            break;
-                    }
-                    ++r;
-                }
+        return: number of items written into out
+    */
+    size_t popBatchTickets(T **out, size_t max, [[maybe_unused]] const int tid = 0)
+    {
+        size_t done = 0;
+
+        while (done < max)
+        {
+            Base::safeCluster();
+            uint64_t h = Base::head.load();
+            uint64_t t = Base::tailIndex(Base::tail.load());
+            if (t <= h)
+                return done;
+            uint64_t want = std::min<uint64_t>(max - done, t - h);
+
+            uint64_t firstTicket = Base::head.fetch_add(want);
+            for (uint64_t headTicket = firstTicket; headTicket < firstTicket + want; ++headTicket)
+            {
+                T *item = dequeueTicket(headTicket);
+                if (item != nullptr)
+                    out[done++] = item;
             }
 
-            if (Base::tailIndex(Base::tail.load()) <= headTicket)
+            if (Base::tailIndex(Base::tail.load()) <= firstTicket + want - 1)
             {
                 Base::fixState();
-                return nullptr; // coda vuota;
+                return done;
             }
         }
+        return done;
+    }
+
+    //batched pop (see popBatchTickets), wakes the parked producers of the bounded queue
+    size_t popBatch(T **out, size_t max, const int tid = 0) {
+        const size_t done = popBatchTickets(out,max,tid);
+        if(done != 0)
+            notFull.notifyAll();
+        return done;
+    }
+
+    /*
+        Blocking push of the bounded queue (backpressure): spins briefly, then parks
+        until a pop frees a cell (or until the timeout, default: no timeout)
+        return: false on timeout
+    */
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    bool pushWait(T *item, const int tid = 0, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) requires bounded {
+        return waitUntil(notFull,waitDeadline(timeout),[this,item,tid](){ return push(item,tid); });
+    }
+
+    /*
+        Blocking pop of the bounded queue: spins briefly, then parks until a push
+        (or until the timeout, default: no timeout)
+        return: nullptr on timeout
+    */
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    T* popWait(const int tid = 0, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) requires bounded {
+        return waitUntil(notEmpty,waitDeadline(timeout),[this,tid](){ return pop(tid); });
     }
 
     inline size_t length([[maybe_unused]] const int tid = 0) const {
         if constexpr (bounded){
-            uint64_t length = Base::tail.load() - Base::head.load();
-            return length < 0 ? 0 : length > size ? size : length;
+            const int64_t length = static_cast<int64_t>(Base::tail.load() - Base::head.load());
+            return length < 0 ? 0 : static_cast<size_t>(length) > size ? size : length;
         } else {
             return Base::length();
         }
     }
 
-    friend class LinkedRingQueue<T,CRQueue<T,padded_cells,bounded>>;   //LinkedRingQueue can access private class members 
+    //slow path and forced close counters (see StarvingPush)
+    inline PushStats getPushStats() const {
+        return starving.getStats();
+    }
+
+    template<class, class, template<typename> class> friend class LinkedRingQueue;   //LinkedRingQueue can access private class members 
+    template<class> friend struct detail::SegmentProbe;
 };
 
 /*
     Declare aliases for Unbounded and Bounded Queues
 */
 #ifndef DISABLE_PADDING
-template<typename T,bool padded_cells=true,bool bounded=false>
+template<typename T,bool padded_cells=true,bool bounded=false,bool remapped_cells=false>
 #else
-template<typename T,bool padded_cells=true,bool bounded=false>
+template<typename T,bool padded_cells=true,bool bounded=false,bool remapped_cells=false>
 #endif
-using LCRQueue = LinkedRingQueue<T,CRQueue<T,padded_cells,bounded>>;
+using LCRQueue = LinkedRingQueue<T,CRQueue<T,padded_cells,bounded,0,remapped_cells>>;
+
+//Same queue with Epoch Based / Interval Based Reclamation, without reclamation of the segments (see Reclaimers.hpp)
+template<typename T,bool padded_cells=true,bool bounded=false>
+using LCRQueueEBR = LinkedRingQueue<T,CRQueue<T,padded_cells,bounded>,EpochBasedReclamation>;
+
+template<typename T,bool padded_cells=true,bool bounded=false>
+using LCRQueueNoReclaim = LinkedRingQueue<T,CRQueue<T,padded_cells,bounded>,NoReclamation>;
+
+template<typename T,bool padded_cells=true,bool bounded=false>
+using LCRQueueIBR = LinkedRingQueue<T,CRQueue<T,padded_cells,bounded>,IntervalBasedReclamation>;
 
 #ifndef DISABLE_PADDING
-template<typename T,bool padded_cells=true,bool bounded=true>
+template<typename T,bool padded_cells=true,bool bounded=true,bool remapped_cells=false>
 #else
-template<typename T,bool padded_cells=false,bool bounded=true>
+template<typename T,bool padded_cells=false,bool bounded=true,bool remapped_cells=false>
 #endif
-using BoundedCRQueue = CRQueue<T,padded_cells,bounded>;
\ No newline at end of file
+using BoundedCRQueue = CRQueue<T,padded_cells,bounded,0,remapped_cells>;
+
+//Unpadded cells with the cache line remapping of the tickets (see detail::CellRemap)
+template<typename T>
+using LCRQueueRemap = LCRQueue<T,false,false,true>;
+
+template<typename T>
+using BoundedCRQueueRemap = CRQueue<T,false,true,0,true>;
+
+//Ring size fixed at compile time (cells embedded in the segment)
+template<typename T>
+using LCRQueueFixed = LinkedRingQueue<T,CRQueue<T,true,false,4096>>;
+
+template<typename T>
+using BoundedCRQueueFixed = CRQueue<T,true,true,4096>;
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include "LinkedRingQueue.hpp"
+#include "RQCell.hpp"
+
+/*
+    Macros:
+    DISABLE_PADDING: disables padding for cells
+    DISABLE_POW2: Disables power of 2 modulo ops
+*/
+
+/*
+    Multi producer / single consumer segment for LinkedRingQueue.
+
+    Producers take a ticket with a fetch_add on the tail and store the item
+    in the cell: a ticket is never abandoned, so the cells need no index and
+    no consumer ever invalidates them (no CAS on the cell as in CRQ / PRQ).
+    The single consumer owns the head: a pop is a load of the cell and a
+    store of the head, no RMW. A cell still empty below the tail belongs to
+    a push in flight: the pop reports the queue as empty, unless the segment
+    has been closed (a next segment may exist) and the consumer waits for
+    the item before moving on.
+
+    The segment is never reused before it is retired: a ticket past the
+    last cell closes the segment and the push goes to the next one.
+*/
+template<typename T,bool padded_cells>
+class MPSCSegment : public QueueSegmentBase<T, MPSCSegment<T,padded_cells>> {
+private:
+    using Base = QueueSegmentBase<T, MPSCSegment<T,padded_cells>>;
+    using Cell = detail::PlainCell<T*,padded_cells>;
+
+    Cell* array;
+    const size_t size;
+#ifndef DISABLE_POW2
+    const size_t mask;  //Mask to execute the modulo operation
+#endif
+    uint64_t start;     //first ticket of the segment
+
+    inline Cell& cellAt(uint64_t ticket) const {
+#ifndef DISABLE_POW2
+        return array[ticket & mask];
+#else
+        return array[ticket % size];
+#endif
+    }
+
+    //uses the tid argument to be consistent with linked queues
+    MPSCSegment(size_t size_par, [[maybe_unused]] const int tid, const uint64_t start): Base(),
+#ifndef DISABLE_POW2
+    size{detail::nextPowTwo(size_par)},
+    mask{size - 1}
+#else
+    size{size_par}
+#endif
+    {
+        assert(size_par > 0);
+        array = new Cell[size];
+        init(start);
+    }
+
+    /*
+        (Re)initializes the ring to start from the given index: used by the constructor
+        and by LinkedRingQueue to recycle a retired segment without reallocating it
+    */
+    void init(const uint64_t startIndex){
+        for(size_t i = 0; i < size; ++i)
+            array[i].val.store(nullptr,std::memory_order_relaxed);
+        start = startIndex;
+        Base::head.store(startIndex,std::memory_order_relaxed);
+        Base::tail.store(startIndex,std::memory_order_relaxed);
+        Base::next.store(nullptr,std::memory_order_relaxed);
+    }
+
+public:
+    //uses the tid argument to be consistent with linked queues
+    MPSCSegment(size_t size_par, [[maybe_unused]] const int tid = 0): MPSCSegment(size_par,tid,0){}
+
+    ~MPSCSegment(){
+        delete[] array;
+    }
+
+    static std::string className(bool padding = true) {
+        using namespace std::string_literals;
+        return "MPSCQueue"s + ((padded_cells && padding)? "/padded":"");
+    }
+
+    /*
+        Takes an additional tid parameter to keep the interface compatible with
+        LinkedRingQueue->push
+        return: false if the segment is full (and now closed)
+    */
+    __attribute__((used,always_inline)) bool push(T* item, [[maybe_unused]] const int tid = 0) {
+        const uint64_t tailTicket = Base::tail.fetch_add(1);
+        if(Base::isClosed(tailTicket))
+            return false;
+        if(tailTicket >= start + size){
+            Base::closeSegment(tailTicket,true);
+            return false;
+        }
+        cellAt(tailTicket).val.store(item,std::memory_order_release);
+        return true;
+    }
+
+    /*
+        Batched push: reserves n tickets with a single fetch_add and fills the
+        cells that fall inside the segment (closing it if some did not fit).
+        return: number of items inserted, the caller carries the rest
+    */
+    size_t pushBatch(T** items, size_t n, [[maybe_unused]] const int tid = 0) {
+        if(n == 0)
+            return 0;
+        const uint64_t firstTicket = Base::tail.fetch_add(n);
+        if(Base::isClosed(firstTicket))
+            return 0;
+        const uint64_t end = start + size;
+        const size_t done = firstTicket >= end ? 0 : std::min<uint64_t>(n, end - firstTicket);
+        for(size_t i = 0; i < done; i++)
+            cellAt(firstTicket + i).val.store(items[i],std::memory_order_release);
+        if(done < n)
+            Base::closeSegment(firstTicket + n - 1,true);
+        return done;
+    }
+
+    /*
+        Single consumer pop.
+        return: the item at the head or nullptr if the segment is empty
+    */
+    __attribute__((used,always_inline)) T* pop([[maybe_unused]] const int tid = 0) {
+        const uint64_t headTicket = Base::head.load(std::memory_order_relaxed);
+        if(headTicket >= start + size)
+            return nullptr;     //drained
+        Cell& cell = cellAt(headTicket);
+        T* item = cell.val.load(std::memory_order_acquire);
+        if(item == nullptr){
+            const uint64_t tt = Base::tail.load();
+            if(!Base::isClosed(tt) || Base::tailIndex(tt) <= headTicket)
+                return nullptr; //empty (or a push in flight on the open segment)
+            //the segment is closed: the producer owning the ticket is storing the item
+            while((item = cell.val.load(std::memory_order_acquire)) == nullptr)
+                std::this_thread::yield();  //the producer may have been descheduled
+        }
+        Base::head.store(headTicket + 1,std::memory_order_release);
+        return item;
+    }
+
+    size_t popBatch(T** out, size_t max, const int tid = 0) {
+        size_t done = 0;
+        while(done < max && (out[done] = pop(tid)) != nullptr)
+            ++done;
+        return done;
+    }
+
+    //the tickets taken past the last cell are not items: the next segment starts at start + size
+    inline uint64_t getTailIndex() const {
+        return std::min<uint64_t>(Base::tailIndex(Base::tail.load()), start + size);
+    }
+
+    inline size_t length([[maybe_unused]] const int tid = 0) const {
+        const uint64_t t = getTailIndex();
+        const uint64_t h = Base::head.load();
+        return t > h ? t - h : 0;
+    }
+
+    template<class, class, template<typename> class> friend class LinkedRingQueue;
+};
+
+/*
+    Declare aliases for the linked queue
+*/
+#ifndef NO_PADDING
+template<typename T,bool padded_cells=true>
+#else
+template<typename T,bool padded_cells=false>
+#endif
+using LMPSCQueue = LinkedRingQueue<T,MPSCSegment<T,padded_cells>>;
@@ -4,66 +4,89 @@
 #include <iostream>
 #include "LinkedRingQueue.hpp"
 #include "RQCell.hpp"
+#include "NumaAllocator.hpp"
+#include "Backoff.hpp"
 #include "x86Atomics.hpp"
 
 #include <chrono>
 
-#define BACKOFF_MIN 128UL
-#define BACKOFF_MAX 1024UL
-
 /**
- * MACROS:  DISABLE_POW2
+ * MACROS:  DISABLE_POW2 (runtime ring size only)
  *          DISABLE_DECAY 
+ *          BACKOFF_MIN / BACKOFF_MAX (see Backoff.hpp)
+ *
+ * N: ring size fixed at compile time, cells embedded in the segment (0: runtime size, see detail::RingSize)
+ * remapped_cells: consecutive tickets on different cache lines (see detail::CellRemap)
+ * Backoff: policy of the failed CAS on head / tail (NoBackoff, ExpBackoff, JitterBackoff, YieldBackoff)
  */
 
-template <typename T,bool padded_cells, bool bounded>
-class MTQueue : public QueueSegmentBase<T, MTQueue<T,padded_cells,bounded>>{
+template <typename T,bool padded_cells, bool bounded, size_t N = 0, bool remapped_cells = false, class Backoff = ExpBackoff>
+class MTQueue : public QueueSegmentBase<T, MTQueue<T,padded_cells,bounded,N,remapped_cells,Backoff>>,
+                private detail::RingSize<N>,
+                public detail::SingleBlockIf<!bounded && N == 0, detail::CRQCell<T*,padded_cells>> {
 private:
-    using Base = QueueSegmentBase<T, MTQueue<T,padded_cells,bounded>>;
+    using Base = QueueSegmentBase<T, MTQueue<T,padded_cells,bounded,N,remapped_cells,Backoff>>;
+    using Ring = detail::RingSize<N>;
     using Cell = detail::CRQCell<T*,padded_cells>;
+    //unbounded segments: cells in the same block (allocated by LinkedRingQueue only, see detail::SingleBlock)
+    static constexpr bool singleBlock = detail::useSingleBlock<!bounded && N == 0, Cell>;
+    using Ring::size;
+    using Ring::position;
+    using Ring::cellsFor;
 
     static constexpr size_t TRY_CLOSE = 10;
 
-    Cell *array;
-    const size_t size;
-#ifndef DISABLE_POW2
-    const size_t mask;  //Mask to execute the modulo operation
-#endif
+    detail::RingArray<Cell,N,singleBlock> array;   //placed following SEGMENT_NUMA_POLICY (bounded, runtime size)
+    //producers parked by pushWait (bounded queue only)
+    [[no_unique_address]] std::conditional_t<bounded,EventCount,NoEventCount> notFull;
+    const detail::CellRemap<Cell,remapped_cells> remap;   //consecutive tickets on different cache lines (unpadded cells)
+
+    inline Cell* cells() const {
+        if constexpr (singleBlock) return detail::trailingCells<Cell>(this);
+        else return array.data();
+    }
+
+    inline Cell& cellAt(uint64_t ticket) const {
+        return cells()[remap(position(ticket))];
+    }
 
 private:
     MTQueue(size_t size_param,[[maybe_unused]] const int tid, uint64_t start): 
     Base(),
-#ifndef DISABLE_POW2
-    size{detail::nextPowTwo(size_param)},
-    mask{size - 1}
-#else
-    size{size_param}
-#endif
+    Ring(size_param),
+    array(size),
+    remap{size}
     {
         if(size == 0)
             throw std::invalid_argument("Ring Size must be greater than 0");
-        array = new Cell[size];
-        for (uint64_t i = start; i < start + size; i++){
-            array[i % size].val.store(nullptr,std::memory_order_relaxed);
-            array[i % size].idx.store(i,std::memory_order_relaxed);
+        init(start);
+    }
 
-            Base::head.store(start,std::memory_order_relaxed);
-            Base::tail.store(start,std::memory_order_relaxed);
+    /*
+        (Re)initializes the ring to start from the given index: used by the constructor
+        and by LinkedRingQueue to recycle a retired segment without reallocating it
+    */
+    void init(const uint64_t start){
+        for (uint64_t i = start; i < start + size; i++){
+            cellAt(i).val.store(nullptr,std::memory_order_relaxed);
+            cellAt(i).idx.store(i,std::memory_order_relaxed);
         }
+        Base::head.store(start,std::memory_order_relaxed);
+        Base::tail.store(start,std::memory_order_relaxed);
+        Base::next.store(nullptr,std::memory_order_relaxed);
     }
 
 
 public:
-    MTQueue(size_t size,[[maybe_unused]] const int tid = 0): MTQueue(size,tid,0){} 
+    MTQueue(size_t size,[[maybe_unused]] const int tid = 0) requires (!singleBlock): MTQueue(size,tid,0){}
 
     ~MTQueue(){
         while(pop(0) != nullptr);
-        delete[] array;
     }
 
     static std::string className(bool padding = true) {
         using namespace std::string_literals;
-        return (bounded? "Bounded"s : ""s ) + "MTQueue"s + ((padded_cells && padding)? "/padded":"");
+        return (bounded? "Bounded"s : ""s ) + "MTQueue"s + Backoff::name + ((padded_cells && padding)? "/padded":"") + (remapped_cells? "/remapped":"") + (N? "/fixed" + std::to_string(N) : "");
     }
 
     /*
@@ -85,7 +108,7 @@ public:
         //puts("PUSHING");
         size_t tailTicket,idx;
         Cell *node;
-        size_t bk = BACKOFF_MIN;
+        Backoff backoff;
         size_t try_close = 0;
         while(true){
             tailTicket = Base::tail.load(std::memory_order_relaxed);
@@ -94,18 +117,12 @@ public:
                     return false;
                 } 
             }
-#ifndef DISABLE_POW2
-            node = &(array[tailTicket & mask]);
-#else
-            node = &(array[tailTicket % size]);
-#endif
+            node = &cellAt(tailTicket);
             idx = node->idx.load(std::memory_order_acquire);
             if(tailTicket == idx){
                 if(Base::tail.compare_exchange_strong(tailTicket,tailTicket + 1)) //try to advance the index
                     break;
-                for (size_t i = 0; i < bk; ++i){asm("");} //so the loop isnt optimized out
-                bk <<= 1;
-                bk &= BACKOFF_MAX;
+                backoff.wait();
             } else {
                 if(tailTicket > idx){
                     if constexpr (bounded){ //if queue is bounded then never closes the segment
@@ -143,24 +160,18 @@ public:
         //puts("POPPING");
         size_t headTicket,idx;
         Cell *node;
-        size_t bk = BACKOFF_MIN;
+        Backoff backoff;
         T* item;    //item to return;
 
         while(true){
             headTicket = Base::head.load(std::memory_order_relaxed);
-#ifndef DISABLE_POW2
-            node = &array[headTicket & mask];
-#else
-            node = &array[headTicket % size];
-#endif
+            node = &cellAt(headTicket);
             idx = node->idx.load(std::memory_order_acquire);
             long diff = idx - (headTicket + 1);
             if(diff == 0){
                 if(Base::head.compare_exchange_strong(headTicket,headTicket + 1)) //try to advance the head
                     break;
-                for (size_t i = 0; i < bk; ++i){asm("");} //so the loop isnt optimized out
-                bk <<= 1;
-                bk &= BACKOFF_MAX;
+                backoff.wait();
             } 
             // else if(diff < 0){//queue is empty [if segment is closed switch to next]
             //     if constexpr (bounded){
@@ -189,32 +200,100 @@ public:
         //std::cerr << "Pushing " << item << " with " << headTicket << " at "<< headTicket % size << std::endl;
         item = node->val;
         node->idx.store(headTicket + size,std::memory_order_release);
+        if constexpr (bounded){
+            detail::asymmetricLightBarrier();   //the free cell must be visible before checking for waiters (heavy side in waitUntil)
+            notFull.notify();
+        }
         return item;
     }
 
+    /*
+        Blocking push of the bounded queue (backpressure): spins briefly, then parks
+        until a pop frees a cell (or until the timeout, default: no timeout)
+        return: false on timeout
+    */
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    bool pushWait(T *item, const int tid = 0, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) requires bounded {
+        return waitUntil(notFull,waitDeadline(timeout),[this,item,tid](){ return push(item,tid); });
+    }
+
     inline size_t length([[maybe_unused]] const int tid = 0) const {
         if constexpr (bounded){
-            uint64_t length = Base::tail.load() - Base::head.load();
-            return length < 0 ? 0 : length > size ? size : length;
+            const int64_t length = static_cast<int64_t>(Base::tail.load() - Base::head.load());
+            return length < 0 ? 0 : static_cast<size_t>(length) > size ? size : length;
         } else {
             return Base::length();
         }
     }
 
-    friend class LinkedRingQueue<T,MTQueue<T,padded_cells,bounded>>;   
+    template<class, class, template<typename> class> friend class LinkedRingQueue;   
 
 };
 
 #ifndef NO_PADDING
-template<typename T,bool padded_cells=true,bool bounded=false>
+template<typename T,bool padded_cells=true,bool bounded=false,bool remapped_cells=false,class Backoff=ExpBackoff>
 #else
+template<typename T,bool padded_cells=true,bool bounded=false,bool remapped_cells=false,class Backoff=ExpBackoff>
+#endif
+using LMTQueue = LinkedRingQueue<T,MTQueue<T,padded_cells,bounded,0,remapped_cells,Backoff>>;
+
+//Same queue with Epoch Based / Interval Based Reclamation, without reclamation of the segments (see Reclaimers.hpp)
+template<typename T,bool padded_cells=true,bool bounded=false>
+using LMTQueueEBR = LinkedRingQueue<T,MTQueue<T,padded_cells,bounded>,EpochBasedReclamation>;
+
 template<typename T,bool padded_cells=true,bool bounded=false>
+using LMTQueueNoReclaim = LinkedRingQueue<T,MTQueue<T,padded_cells,bounded>,NoReclamation>;
+
+template<typename T,bool padded_cells=true,bool bounded=false>
+using LMTQueueIBR = LinkedRingQueue<T,MTQueue<T,padded_cells,bounded>,IntervalBasedReclamation>;
+
+#ifndef NO_PADDING
+template<typename T,bool padded_cells=true,bool bounded=true,bool remapped_cells=false,class Backoff=ExpBackoff>
+#else
+template<typename T,bool padded_cells=false,bool bounded=true,bool remapped_cells=false,class Backoff=ExpBackoff>
 #endif
-using LMTQueue = LinkedRingQueue<T,MTQueue<T,padded_cells,bounded>>;
+using BoundedMTQueue = MTQueue<T,padded_cells,bounded,0,remapped_cells,Backoff>;
+
+//Same queues with every backoff policy of the CAS retries (see Backoff.hpp)
+template<typename T>
+using LMTQueueNoBackoff = LMTQueue<T,true,false,false,NoBackoff>;
+
+template<typename T>
+using LMTQueueJitter = LMTQueue<T,true,false,false,JitterBackoff>;
+
+template<typename T>
+using LMTQueueYield = LMTQueue<T,true,false,false,YieldBackoff>;
 
 #ifndef NO_PADDING
-template<typename T,bool padded_cells=true,bool bounded=true>
+template<typename T>
+using BoundedMTQueueNoBackoff = BoundedMTQueue<T,true,true,false,NoBackoff>;
+
+template<typename T>
+using BoundedMTQueueJitter = BoundedMTQueue<T,true,true,false,JitterBackoff>;
+
+template<typename T>
+using BoundedMTQueueYield = BoundedMTQueue<T,true,true,false,YieldBackoff>;
 #else
-template<typename T,bool padded_cells=false,bool bounded=true>
+template<typename T>
+using BoundedMTQueueNoBackoff = BoundedMTQueue<T,false,true,false,NoBackoff>;
+
+template<typename T>
+using BoundedMTQueueJitter = BoundedMTQueue<T,false,true,false,JitterBackoff>;
+
+template<typename T>
+using BoundedMTQueueYield = BoundedMTQueue<T,false,true,false,YieldBackoff>;
 #endif
-using BoundedMTQueue = MTQueue<T,padded_cells,bounded>;
\ No newline at end of file
+
+//Unpadded cells with the cache line remapping of the tickets (see detail::CellRemap)
+template<typename T>
+using LMTQueueRemap = LMTQueue<T,false,false,true>;
+
+template<typename T>
+using BoundedMTQueueRemap = BoundedMTQueue<T,false,true,true>;
+
+//Ring size fixed at compile time (cells embedded in the segment)
+template<typename T>
+using LMTQueueFixed = LinkedRingQueue<T,MTQueue<T,true,false,4096>>;
+
+template<typename T>
+using BoundedMTQueueFixed = MTQueue<T,true,true,4096>;
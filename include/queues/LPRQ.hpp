@@ -1,29 +1,44 @@
 #pragma once
 
 #include <atomic>
+#include <algorithm>
 #include "LinkedRingQueue.hpp"
 #include "RQCell.hpp"
+#include "NumaAllocator.hpp"
+#include "StarvingPush.hpp"
 
 /*
     Macros:
     DISABLE_PADDING: disables padding for cells
-    DISABLE_POW2: Disables power of 2 modulo ops
+    DISABLE_POW2: Disables power of 2 modulo ops (runtime ring size only)
     CAUTIOUS_DEQUEUE: check that the queue is empty before attempt pop
+
+    N: ring size fixed at compile time, cells embedded in the segment (0: runtime size, see detail::RingSize)
 */
 
-template<typename T,bool padded_cells, bool bounded>
-class PRQueue : public QueueSegmentBase<T, PRQueue<T,padded_cells,bounded>> {
+template<typename T,bool padded_cells, bool bounded, size_t N = 0, bool remapped_cells = false>
+class PRQueue : public QueueSegmentBase<T, PRQueue<T,padded_cells,bounded,N,remapped_cells>>,
+                private detail::RingSize<N>,
+                public detail::SingleBlockIf<!bounded && N == 0, detail::CRQCell<void*,padded_cells>> {
 private:
-    using Base = QueueSegmentBase<T,PRQueue<T,padded_cells,bounded>>;
+    using Base = QueueSegmentBase<T,PRQueue<T,padded_cells,bounded,N,remapped_cells>>;
+    using Ring = detail::RingSize<N>;
     using Cell = detail::CRQCell<void*,padded_cells>;
+    //unbounded segments: cells in the same block (allocated by LinkedRingQueue only, see detail::SingleBlock)
+    static constexpr bool singleBlock = detail::useSingleBlock<!bounded && N == 0, Cell>;
+    using Ring::size;
+    using Ring::position;
+    using Ring::cellsFor;
 
-    static constexpr size_t TRY_CLOSE = 10;
-    
-    Cell* array; 
-    const size_t size;
-#ifndef DISABLE_POW2
-    const size_t mask;  //Mask to execute the modulo operation
-#endif
+    detail::RingArray<Cell,N,singleBlock> array;   //placed following SEGMENT_NUMA_POLICY (bounded, runtime size)
+
+    detail::StarvingPush<T> starving;  //slow path of the producers failing STARVATION_THRESHOLD times
+
+    //consumers parked by popWait (only the bounded queue blocks: segments are woken by LinkedRingQueue)
+    [[no_unique_address]] std::conditional_t<bounded,EventCount,NoEventCount> notEmpty;
+    //producers parked by pushWait (bounded queue only)
+    [[no_unique_address]] std::conditional_t<bounded,EventCount,NoEventCount> notFull;
+    const detail::CellRemap<Cell,remapped_cells> remap;   //consecutive tickets on different cache lines (unpadded cells)
 
     /* Private class methods */
     inline uint64_t nodeIndex(uint64_t i) const {return (i & ~(1ull << 63));}
@@ -34,42 +49,159 @@ private:
         return reinterpret_cast<void*>(static_cast<uintptr_t>((tid << 1) | 1));
     }
 
+    inline Cell* cells() const {
+        if constexpr (singleBlock) return detail::trailingCells<Cell>(this);
+        else return array.data();
+    }
+
+    inline Cell& cellAt(uint64_t ticket) const {
+        return cells()[remap(position(ticket))];
+    }
+
+    /*
+        Tries to store item in the cell of tailTicket (the ticket is already owned)
+        return: true if the item has been inserted
+    */
+    __attribute__((always_inline)) bool enqueueTicket(const uint64_t tailTicket, T* item, const int tid) {
+        Cell& cell = cellAt(tailTicket);
+        uint64_t idx = cell.idx.load();
+        void* val = cell.val.load();
+
+        if( val == nullptr
+            && nodeIndex(idx) <= tailTicket
+            && (!nodeUnsafe(idx) || Base::head.load() <= tailTicket)) 
+        {
+            void* bottom = threadLocalBottom(tid);
+            if(cell.val.compare_exchange_strong(val,bottom)) {
+                if(cell.idx.compare_exchange_strong(idx,tailTicket + size)) {
+                    if(cell.val.compare_exchange_strong(bottom, item)) {
+                        return true;
+                    }
+                } else {
+                    cell.val.compare_exchange_strong(bottom, nullptr);
+                }
+            }
+        }
+        return false;
+    }
+
+    /*
+        Consumes the cell of headTicket (the ticket is already owned)
+        return: the item stored for headTicket or nullptr if the cell has been invalidated
+    */
+    __attribute__((always_inline)) T* dequeueTicket(const uint64_t headTicket) {
+        Cell& cell = cellAt(headTicket);
+
+        int r = 0;
+        uint64_t tt = 0;
+
+        while(1) {
+            uint64_t cell_idx   = cell.idx.load();
+            uint64_t unsafe     = nodeUnsafe(cell_idx);
+            uint64_t idx        = nodeIndex(cell_idx);
+
+            void* val           = cell.val.load();
+
+            if(val != nullptr && !isBottom(val)){
+                if(idx == headTicket + size){
+                    cell.val.store(nullptr);
+                    return static_cast<T*>(val);
+                } else {
+                    if(unsafe) {
+                        if(cell.idx.load() == cell_idx)
+                            return nullptr;
+                    } else {
+                        if(cell.idx.compare_exchange_strong(cell_idx,setUnsafe(idx)))
+                            return nullptr;
+                    }
+                }
+            } else {
+                if((r & ((1ull << 8 ) -1 )) == 0)
+                    tt = Base::tail.load();
+
+                int closed = Base::isClosed(tt);    //in case "bounded" it's always false
+                uint64_t t = Base::tailIndex(tt);
+                if(unsafe || t < headTicket + 1  || r > 4 * 1024 || closed) {
+                    if(isBottom(val) && !cell.val.compare_exchange_strong(val,nullptr))
+                        continue;
+                    if(cell.idx.compare_exchange_strong(cell_idx, unsafe | (headTicket + size)))
+                        return nullptr;
+                }
+                ++r;
+            }
+        }
+    }
+
+    /*
+        Slow path of a producer that failed STARVATION_THRESHOLD tickets (tailTicket is the last one):
+        publishes the item for the consumers finding the ring empty, if nobody takes it
+        the producer takes it back and only then a full segment is closed (BIT_TEST_AND_SET63)
+    */
+    detail::SlowPush slowPush(T* item, const uint64_t tailTicket) {
+        if(starving.publish(item))
+            return detail::SlowPush::Helped;
+        if constexpr (bounded == false){
+            if(tailTicket >= Base::head.load() + size && Base::closeSegment(tailTicket, true)){
+                starving.countForcedClose();
+                return detail::SlowPush::Closed;
+            }
+        }
+        return detail::SlowPush::Retry;
+    }
+
+    //empty ring: takes the item of a starving producer, if any (open segments only)
+    inline T* helpStarving() {
+        if constexpr (bounded == false){
+            if(Base::isClosed(Base::tail.load()))
+                return nullptr;
+        }
+        return starving.help();
+    }
+
 private:
     //uses the tid argument to be consistent with linked queues
-    PRQueue(size_t size_par, [[maybe_unused]] const int tid, const uint64_t start): Base(),
-#ifndef DISABLE_POW2
-    size{detail::nextPowTwo(size_par)},
-    mask{size - 1}
-#else
-    size{size_par}
-#endif
+    PRQueue(size_t size_par, [[maybe_unused]] const int tid, const uint64_t start): Base(), Ring(size_par),
+    array(size),
+    remap{size}
     {
         assert(size_par > 0);
-        array = new Cell[size];
+        init(start);
+    }
 
+    /*
+        (Re)initializes the ring to start from the given index: used by the constructor
+        and by LinkedRingQueue to recycle a retired segment without reallocating it
+    */
+    void init(const uint64_t start){
         for(uint64_t i = start; i < start + size; ++i){
-            array[i % size].val.store(nullptr,memory_order_relaxed);
-            array[i % size].idx.store(i,memory_order_relaxed);           
+            cellAt(i).val.store(nullptr,memory_order_relaxed);
+            cellAt(i).idx.store(i,memory_order_relaxed);
         }
 
         Base::head.store(start,memory_order_relaxed);
         Base::tail.store(start,memory_order_relaxed);
+        Base::next.store(nullptr,memory_order_relaxed);
+        starving.reset();
         //Numa optimization
-        Base::cluster.store((isNumaAvailable() ? getNumaNode() : 0), memory_order_relaxed );
+        Base::cohort.reset(Base::clusterNode());
     }
 
 public:
     //uses the tid argument to be consistent with linked queues
-    PRQueue(size_t size_par, [[maybe_unused]] const int tid = 0): PRQueue(size_par,tid,0){}
+    PRQueue(size_t size_par, [[maybe_unused]] const int tid = 0) requires (!singleBlock): PRQueue(size_par,tid,0){}
 
     ~PRQueue(){
         while(pop(0) != nullptr);
-        delete[] array;
     }
 
     static std::string className(bool padding = true) {
         using namespace std::string_literals;
-        return (bounded? "Bounded"s : ""s ) + "PRQueue"s + ((padded_cells && padding)? "/padded":"");
+        return (bounded? "Bounded"s : ""s ) + "PRQueue"s + ((padded_cells && padding)? "/padded":"") + (remapped_cells? "/remapped":"") + (N? "/fixed" + std::to_string(N) : "");
+    }
+
+    //memory taken by every slot of the ring
+    static constexpr size_t bytesPerSlot() {
+        return sizeof(Cell);
     }
 
     /*
@@ -78,7 +210,7 @@ public:
         The parameter has a default value so that it can be omitted
     */
     __attribute__((used,always_inline)) bool push(T* item,[[maybe_unused]] const int tid = 0) {
-        int try_close = 0;
+        int failures = 0;
     
         while(true) {
 
@@ -91,28 +223,10 @@ public:
                     return false;
                 }
             }
-#ifndef DISABLE_POW2
-            Cell& cell = array[tailTicket & mask];
-#else
-            Cell& cell = array[tailTicket % size];
-#endif
-            uint64_t idx = cell.idx.load();
-            void* val = cell.val.load();
-
-            if( val == nullptr
-                && nodeIndex(idx) <= tailTicket
-                && (!nodeUnsafe(idx) || Base::head.load() <= tailTicket)) 
-            {
-                void* bottom = threadLocalBottom(tid);
-                if(cell.val.compare_exchange_strong(val,bottom)) {
-                    if(cell.idx.compare_exchange_strong(idx,tailTicket + size)) {
-                        if(cell.val.compare_exchange_strong(bottom, item)) {
-                            return true;
-                        }
-                    } else {
-                        cell.val.compare_exchange_strong(bottom, nullptr);
-                    }
-                }
+
+            if(enqueueTicket(tailTicket, item, tid)) {
+                notEmpty.notify();   //a load if no consumer is parked
+                return true;
             }
 
             if(tailTicket >= Base::head.load() + size){
@@ -120,14 +234,91 @@ public:
                     return false;
                 }
                 else{
-                    if (Base::closeSegment(tailTicket, ++try_close > TRY_CLOSE))
+                    if (Base::closeSegment(tailTicket, false))
                         return false;
                 }
             }  
 
+            //starving: a consumer completes the push, otherwise a full ring is closed
+            if(++failures >= STARVATION_THRESHOLD){
+                const detail::SlowPush outcome = slowPush(item, tailTicket);
+                if(outcome != detail::SlowPush::Retry)
+                    return outcome == detail::SlowPush::Helped;
+                failures = 0;
+            }
         }
     }
 
+    /*
+        Batched push: reserves a whole range of tickets with a single fetch_add
+        (clamped to the free space of the ring) and fills the claimed cells in order.
+
+        return: number of items inserted (less than n if the ring is full or
+                the segment has been closed, the caller carries the rest)
+    */
+    size_t pushBatchTickets(T** items, size_t n, [[maybe_unused]] const int tid = 0) {
+        size_t done = 0;
+        int failures = 0;
+
+        while(done < n) {
+
+            Base::safeCluster();
+
+            uint64_t tt = Base::tail.load();
+            if constexpr (bounded == false){
+                if(Base::isClosed(tt))
+                    return done;
+            }
+            uint64_t limit = Base::head.load() + size;
+            uint64_t free = (Base::tailIndex(tt) < limit)? limit - Base::tailIndex(tt) : 1;
+            uint64_t want = std::min<uint64_t>(n - done, free);
+
+            uint64_t firstTicket = Base::tail.fetch_add(want);
+            if constexpr (bounded == false){
+                if(Base::isClosed(firstTicket))
+                    return done;
+            }
+
+            for(uint64_t tailTicket = firstTicket; tailTicket < firstTicket + want; ++tailTicket) {
+                if(enqueueTicket(tailTicket, items[done], tid)) {
+                    ++done;
+                    failures = 0;
+                    continue;
+                }
+                const bool full = tailTicket >= Base::head.load() + size;
+                if(full){ //the rest of the range is beyond the ring capacity
+                    if constexpr (bounded){
+                        return done;
+                    }
+                    else{
+                        if(Base::closeSegment(firstTicket + want - 1, false))
+                            return done;
+                    }
+                }
+                //starving on items[done]: same slow path as push, then a new range for the rest
+                if(++failures >= STARVATION_THRESHOLD){
+                    const detail::SlowPush outcome = slowPush(items[done], tailTicket);
+                    if(outcome == detail::SlowPush::Closed)
+                        return done;
+                    if(outcome == detail::SlowPush::Helped)
+                        ++done;
+                    failures = 0;
+                    break;
+                }
+                if(full)
+                    break;
+            }
+        }
+        return done;
+    }
+
+    size_t pushBatch(T** items, size_t n, const int tid = 0) {
+        const size_t done = pushBatchTickets(items,n,tid);
+        if(done != 0)
+            notEmpty.notifyAll();
+        return done;
+    }
+
     /*
         Takes an additional tid parameter to keep the interface compatible with
         LinkedRingQueue->push
@@ -143,69 +334,99 @@ public:
             Base::safeCluster();
 
             uint64_t headTicket = Base::head.fetch_add(1);
-#ifndef DISABLE_POW2
-            Cell& cell = array[headTicket & mask];
-#else
-            Cell& cell = array[headTicket % size];
-#endif
 
-            int r = 0;
-            uint64_t tt = 0;
+            T* item = dequeueTicket(headTicket);
+            if(item != nullptr) {
+                notFull.notify();    //a load if no producer is parked
+                return item;
+            }
 
-            while(1) {
-                uint64_t cell_idx   = cell.idx.load();
-                uint64_t unsafe     = nodeUnsafe(cell_idx);
-                uint64_t idx        = nodeIndex(cell_idx);
+            if(Base::tailIndex(Base::tail.load()) <= headTicket + 1){
+                Base::fixState();
+                return helpStarving();
+            }
+        }
+    }
 
-                void* val           = cell.val.load();
+    /*
+        Batched pop: reserves up to max tickets with a single fetch_add (never
+        more than the items currently in the ring) and drains the claimed cells.
 
-                if(val != nullptr && !isBottom(val)){
-                    if(idx == headTicket + size){
-                        cell.val.store(nullptr);
-                        return static_cast<T*>(val);
-                    } else {
-                        if(unsafe) {
-                            if(cell.idx.load() == cell_idx)
-                                break;
-                        } else {
-                            if(cell.idx.compare_exchange_strong(cell_idx,setUnsafe(idx)))
-                                break;
-                        }
-                    }
-                } else {
-                    if((r & ((1ull << 8 ) -1 )) == 0)
-                        tt = Base::tail.load();
-
-                    int closed = Base::isClosed(tt);    //in case "bounded" it's always false
-                    uint64_t t = Base::tailIndex(tt);
-                    if(unsafe || t < headTicket + 1  || r > 4 * 1024 || closed) {
-                        if(isBottom(val) && !cell.val.compare_exchange_strong(val,nullptr))
-                            continue;
-                        if(cell.idx.compare_exchange_strong(cell_idx, unsafe | (headTicket + size)))
-                            break;
-                    }
-                    ++r;
-                }
+        return: number of items written into out
+    */
+    size_t popBatchTickets(T** out, size_t max, [[maybe_unused]] const int tid = 0) {
+        size_t done = 0;
+
+        while(done < max) {
+
+            Base::safeCluster();
+
+            uint64_t h = Base::head.load();
+            uint64_t t = Base::tailIndex(Base::tail.load());
+            if(t <= h)
+                return done;
+            uint64_t want = std::min<uint64_t>(max - done, t - h);
+
+            uint64_t firstTicket = Base::head.fetch_add(want);
+            for(uint64_t headTicket = firstTicket; headTicket < firstTicket + want; ++headTicket) {
+                T* item = dequeueTicket(headTicket);
+                if(item != nullptr)
+                    out[done++] = item;
             }
 
-            if(Base::tailIndex(Base::tail.load()) <= headTicket + 1){
+            if(Base::tailIndex(Base::tail.load()) <= firstTicket + want){
                 Base::fixState();
-                return nullptr;
+                return done;
             }
         }
+        return done;
+    }
+
+    //batched pop (see popBatchTickets), wakes the parked producers of the bounded queue
+    size_t popBatch(T** out, size_t max, const int tid = 0) {
+        const size_t done = popBatchTickets(out,max,tid);
+        if(done != 0)
+            notFull.notifyAll();
+        return done;
+    }
+
+    /*
+        Blocking push of the bounded queue (backpressure): spins briefly, then parks
+        until a pop frees a cell (or until the timeout, default: no timeout)
+        return: false on timeout
+    */
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    bool pushWait(T* item, const int tid = 0, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) requires bounded {
+        return waitUntil(notFull,waitDeadline(timeout),[this,item,tid](){ return push(item,tid); });
+    }
+
+    /*
+        Blocking pop of the bounded queue: spins briefly, then parks until a push
+        (or until the timeout, default: no timeout)
+        return: nullptr on timeout
+    */
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    T* popWait(const int tid = 0, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) requires bounded {
+        return waitUntil(notEmpty,waitDeadline(timeout),[this,tid](){ return pop(tid); });
     }
 
     inline size_t length([[maybe_unused]] const int tid = 0) const {
         if constexpr (bounded){
-            uint64_t length = Base::tail.load() - Base::head.load();
-            return length < 0 ? 0 : length > size ? size : length;
+            const int64_t length = static_cast<int64_t>(Base::tail.load() - Base::head.load());
+            return length < 0 ? 0 : static_cast<size_t>(length) > size ? size : length;
         } else {
             return Base::length();
         }
     }
 
+    //slow path and forced close counters (see StarvingPush)
+    inline PushStats getPushStats() const {
+        return starving.getStats();
+    }
+
 public: 
-    friend class LinkedRingQueue<T,PRQueue<T,padded_cells,bounded>>;   
+    template<class, class, template<typename> class> friend class LinkedRingQueue;   
+    template<class> friend struct detail::SegmentProbe;
   
 };
 
@@ -219,6 +440,16 @@ template<typename T,bool padded_cells=true,bool bounded=false>
 #endif
 using LPRQueue = LinkedRingQueue<T,PRQueue<T,true,false>>;
 
+//Same queue with Epoch Based / Interval Based Reclamation, without reclamation of the segments (see Reclaimers.hpp)
+template<typename T,bool padded_cells=true,bool bounded=false>
+using LPRQueueEBR = LinkedRingQueue<T,PRQueue<T,true,false>,EpochBasedReclamation>;
+
+template<typename T,bool padded_cells=true,bool bounded=false>
+using LPRQueueNoReclaim = LinkedRingQueue<T,PRQueue<T,true,false>,NoReclamation>;
+
+template<typename T,bool padded_cells=true,bool bounded=false>
+using LPRQueueIBR = LinkedRingQueue<T,PRQueue<T,true,false>,IntervalBasedReclamation>;
+
 #ifndef NO_PADDING
 template<typename T,bool padded_cells=true,bool bounded=true>
 using BoundedPRQueue = PRQueue<T,true,true>;
@@ -226,3 +457,17 @@ using BoundedPRQueue = PRQueue<T,true,true>;
 template<typename T,bool padded_cells=false,bool bounded=true>
 using BoundedPRQueue = PRQueue<T,false,true>;
 #endif
+
+//Unpadded cells with the cache line remapping of the tickets (see detail::CellRemap)
+template<typename T>
+using LPRQueueRemap = LinkedRingQueue<T,PRQueue<T,false,false,0,true>>;
+
+template<typename T>
+using BoundedPRQueueRemap = PRQueue<T,false,true,0,true>;
+
+//Ring size fixed at compile time (cells embedded in the segment)
+template<typename T>
+using LPRQueueFixed = LinkedRingQueue<T,PRQueue<T,true,false,4096>>;
+
+template<typename T>
+using BoundedPRQueueFixed = PRQueue<T,true,true,4096>;
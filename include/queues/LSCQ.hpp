@@ -0,0 +1,264 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <algorithm>
+
+#include "LinkedRingQueue.hpp"
+#include "RQCell.hpp"
+
+/*
+    Scalable Circular Queue segment (R. Nikolaev, SCQ / LSCQ) without CAS2.
+
+    The items live in a separate data array of n slots; two rings of 2n
+    single-word entries hold the slot indexes: fq the free slots, aq the
+    allocated ones. A push takes a free index from fq, stores the item in
+    the data array and appends the index to aq; a pop does the opposite.
+
+    An entry packs the cycle of its ticket, the safe bit and the index in one
+    64 bit word: every update is a single-word CAS (or OR), no cmpxchg16b.
+    Each ring has a threshold (3n - 1) reset by every enqueue and decremented
+    by every failed dequeue: once it is negative the ring is empty and the
+    dequeuers return without taking a ticket (no livelock on an empty ring).
+
+    aq uses the head / tail of QueueSegmentBase, so the segment is closed
+    (finalized) through the closed bit of the tail.
+    The size is always rounded up to a power of 2 (the entry encoding needs it).
+*/
+template<typename T>
+class SCQueue : public QueueSegmentBase<T, SCQueue<T>> {
+private:
+    using Base = QueueSegmentBase<T, SCQueue<T>>;
+    using Entry = std::atomic<uint64_t>;
+
+    static constexpr uint64_t EMPTY = ~0ull;
+    static constexpr int MAX_ATTEMPTS = 10000;  //unsafe entry: retries before the dequeuer invalidates it
+
+    const size_t half;      //data slots
+    const size_t n;         //ring entries (2 * half)
+    const int64_t threshold3;
+
+    Entry* aqEntries;
+    Entry* fqEntries;
+    T** data;
+
+    alignas(CACHE_LINE) std::atomic<int64_t> aqThreshold;
+    alignas(CACHE_LINE) std::atomic<uint64_t> fqHead;
+    alignas(CACHE_LINE) std::atomic<uint64_t> fqTail;
+    alignas(CACHE_LINE) std::atomic<int64_t> fqThreshold;
+
+    static inline bool before(uint64_t a, uint64_t b) {
+        return static_cast<int64_t>(a - b) < 0;
+    }
+
+    inline Entry& entryAt(Entry* entries, uint64_t ticket) const {
+        return entries[ticket & (n - 1)];
+    }
+
+    /*
+        Appends eidx to the ring
+        return: false if finalize and the ring has been closed
+    */
+    bool enqueueIndex(Entry* entries, std::atomic<uint64_t>& head, std::atomic<uint64_t>& tail,
+                      std::atomic<int64_t>& threshold, uint64_t eidx, const bool finalize) {
+        eidx ^= (n - 1);
+        while(true){
+            uint64_t ticket = tail.fetch_add(1);
+            if(finalize){
+                if(Base::isClosed(ticket))
+                    return false;
+            }
+            const uint64_t tcycle = (ticket << 1) | (2 * n - 1);
+            Entry& entry = entryAt(entries,ticket);
+            uint64_t e = entry.load();
+            while(true){
+                const uint64_t ecycle = e | (2 * n - 1);
+                if(!before(ecycle,tcycle))
+                    break;      //the entry is still in use: take another ticket
+                if(e != ecycle && (e != (ecycle ^ n) || before(ticket,head.load())))
+                    break;      //occupied, or unsafe and a dequeuer is already past the ticket
+                if(entry.compare_exchange_weak(e,tcycle ^ eidx)){
+                    if(threshold.load() != threshold3)
+                        threshold.store(threshold3);
+                    return true;
+                }
+            }
+        }
+    }
+
+    //moves the tail up to the head after dequeuers overran it (a closed tail is never replaced: it would reopen the ring)
+    void catchup(std::atomic<uint64_t>& head, std::atomic<uint64_t>& tail, uint64_t t, uint64_t h) {
+        while(!Base::isClosed(t) && !tail.compare_exchange_weak(t,h)){
+            h = head.load();
+            t = tail.load();
+            if(!before(t,h))
+                return;
+        }
+    }
+
+    /*
+        Takes the first index of the ring
+        return: the index or EMPTY
+    */
+    uint64_t dequeueIndex(Entry* entries, std::atomic<uint64_t>& head, std::atomic<uint64_t>& tail,
+                          std::atomic<int64_t>& threshold) {
+        if(threshold.load() < 0)
+            return EMPTY;
+        while(true){
+            const uint64_t ticket = head.fetch_add(1);
+            const uint64_t hcycle = (ticket << 1) | (2 * n - 1);
+            Entry& entry = entryAt(entries,ticket);
+            int attempt = 0;
+            uint64_t e = entry.load();
+            while(true){
+                const uint64_t ecycle = e | (2 * n - 1);
+                if(ecycle == hcycle){
+                    entry.fetch_or(n - 1);  //consumed
+                    return e & (n - 1);
+                }
+                uint64_t next;
+                if((e | n) != ecycle){
+                    next = e & ~static_cast<uint64_t>(n);  //clears the safe bit: the enqueuer of this cycle must give up
+                    if(e == next)
+                        break;
+                } else {
+                    if(++attempt <= MAX_ATTEMPTS){
+                        e = entry.load();   //an enqueuer may be about to fill the entry
+                        continue;
+                    }
+                    next = hcycle ^ ((~e) & n);     //empty entry: moves it to the current cycle
+                }
+                if(!before(ecycle,hcycle) || entry.compare_exchange_weak(e,next))
+                    break;
+            }
+
+            const uint64_t tt = tail.load();
+            if(!before(ticket + 1,Base::tailIndex(tt))){
+                if(!Base::isClosed(tt))
+                    catchup(head,tail,tt,ticket + 1);
+                threshold.fetch_sub(1);
+                return EMPTY;
+            }
+            if(threshold.fetch_sub(1) <= 0)
+                return EMPTY;
+        }
+    }
+
+    //uses the tid argument to be consistent with linked queues
+    SCQueue(size_t size_par, [[maybe_unused]] const int tid, const uint64_t start): Base(),
+    half{detail::nextPowTwo(size_par)},
+    n{2 * half},
+    threshold3{static_cast<int64_t>(half + n - 1)}
+    {
+        assert(size_par > 0);
+        aqEntries = new Entry[n];
+        fqEntries = new Entry[n];
+        data = new T*[half];
+        init(start);
+    }
+
+    /*
+        (Re)initializes the segment to start from the given index: used by the constructor
+        and by LinkedRingQueue to recycle a retired segment without reallocating it.
+        aq is empty, fq holds every slot
+    */
+    void init(const uint64_t start){
+        for(size_t i = 0; i < n; i++)
+            aqEntries[i].store(EMPTY,std::memory_order_relaxed);
+        for(size_t i = 0; i < half; i++)
+            fqEntries[i].store(n + i,std::memory_order_relaxed);
+        for(size_t i = half; i < n; i++)
+            fqEntries[i].store(EMPTY,std::memory_order_relaxed);
+
+        Base::head.store(start,std::memory_order_relaxed);
+        Base::tail.store(start,std::memory_order_relaxed);
+        Base::next.store(nullptr,std::memory_order_relaxed);
+        aqThreshold.store(-1,std::memory_order_relaxed);
+        fqHead.store(0,std::memory_order_relaxed);
+        fqTail.store(half,std::memory_order_relaxed);
+        fqThreshold.store(threshold3,std::memory_order_relaxed);
+    }
+
+public:
+    //uses the tid argument to be consistent with linked queues
+    SCQueue(size_t size_par, [[maybe_unused]] const int tid = 0): SCQueue(size_par,tid,0){}
+
+    ~SCQueue(){
+        delete[] aqEntries;
+        delete[] fqEntries;
+        delete[] data;
+    }
+
+    static std::string className([[maybe_unused]] bool padding = true) {
+        return "SCQueue";
+    }
+
+    //memory taken by every slot: two ring entries in aq, two in fq and the data pointer
+    static constexpr size_t bytesPerSlot() {
+        return 4 * sizeof(Entry) + sizeof(T*);
+    }
+
+    /*
+        Takes an additional tid parameter to keep the interface compatible with
+        LinkedRingQueue->push
+        return: false if the segment is full (and now closed)
+    */
+    __attribute__((used,always_inline)) bool push(T* item, [[maybe_unused]] const int tid = 0) {
+        if(Base::isClosed(Base::tail.load()))
+            return false;
+        const uint64_t eidx = dequeueIndex(fqEntries,fqHead,fqTail,fqThreshold);
+        if(eidx == EMPTY){
+            Base::closeSegment(Base::tail.load(),true);
+            return false;
+        }
+        data[eidx] = item;
+        return enqueueIndex(aqEntries,Base::head,Base::tail,aqThreshold,eidx,true);
+        //on failure the slot is lost: the segment is closed and will be retired
+    }
+
+    /*
+        Takes an additional tid parameter to keep the interface compatible with
+        LinkedRingQueue->pop
+        return: the item or nullptr if the segment is empty
+    */
+    __attribute__((used,always_inline)) T* pop([[maybe_unused]] const int tid = 0) {
+        uint64_t eidx = dequeueIndex(aqEntries,Base::head,Base::tail,aqThreshold);
+        if(eidx == EMPTY){
+            if(Base::next.load() == nullptr)
+                return nullptr;
+            //closed segment: the threshold may have run out before the last pushes completed
+            aqThreshold.store(threshold3);
+            eidx = dequeueIndex(aqEntries,Base::head,Base::tail,aqThreshold);
+            if(eidx == EMPTY)
+                return nullptr;
+        }
+        T* item = data[eidx];
+        enqueueIndex(fqEntries,fqHead,fqTail,fqThreshold,eidx,false);
+        return item;
+    }
+
+    inline size_t length([[maybe_unused]] const int tid = 0) const {
+        const uint64_t t = Base::getTailIndex();
+        const uint64_t h = Base::head.load();
+        return t > h ? t - h : 0;
+    }
+
+    template<class, class, template<typename> class> friend class LinkedRingQueue;
+};
+
+/*
+    Declare aliases for the linked queue
+*/
+template<typename T>
+using LSCQueue = LinkedRingQueue<T,SCQueue<T>>;
+
+//Same queue with Epoch Based / Interval Based Reclamation, without reclamation of the segments (see Reclaimers.hpp)
+template<typename T>
+using LSCQueueEBR = LinkedRingQueue<T,SCQueue<T>,EpochBasedReclamation>;
+
+template<typename T>
+using LSCQueueNoReclaim = LinkedRingQueue<T,SCQueue<T>,NoReclamation>;
+
+template<typename T>
+using LSCQueueIBR = LinkedRingQueue<T,SCQueue<T>,IntervalBasedReclamation>;
@@ -1,25 +1,33 @@
 #pragma once
 #include "x86Atomics.hpp"
-#include "HazardPointers.hpp"
+#include "Reclaimers.hpp"
+#include "SegmentPool.hpp"
+#include "EventCount.hpp"
+#include "StarvingPush.hpp"   //PushStats
 #include <stdexcept>
 #include <cstddef>  // For alignas
 #include <cassert>
 #include <atomic>
-#include <chrono>   //For NUMA Timeout
+#include <memory>
 #include "numa_support.hpp"
+#include "ClusterPolicy.hpp"
+#include "NumaAllocator.hpp"
 
 #ifndef CACHE_LINE
 #define CACHE_LINE 64
 #endif
 
-#ifndef CLUSTER_TIMEOUT //microseconds
-#define CLUSTER_TIMEOUT 100
-#endif
-
-template<class T, class Segment>
+/*
+    Reclaimer: memory reclamation policy for the retired segments
+    (HazardPointers, EpochBasedReclamation, NoReclamation - see Reclaimers.hpp)
+*/
+template<class T, class Segment, template<typename> class Reclaimer = DefaultReclaimer>
 class LinkedRingQueue{
+public:
+    using Domain = Reclaimer<Segment>;  //reclamation domain, private to the queue or shared (see makeDomain)
+
 private:
-    static constexpr size_t MAX_THREADS = HazardPointers<Segment*>::MAX_THREADS;
+    static constexpr size_t MAX_THREADS = Reclaimer<Segment>::MAX_THREADS;
     static constexpr int kHpTail = 0;
     static constexpr int kHpHead = 1;
     const size_t maxThreads;
@@ -27,93 +35,237 @@ private:
 
     alignas(CACHE_LINE) std::atomic<Segment*> head;
     alignas(CACHE_LINE) std::atomic<Segment*> tail;
-    
-    HazardPointers<Segment> HP; //Hazard Pointer matrix to ensure no memory leaks on concurrent allocations and deletions
+    EventCount notEmpty;    //consumers parked by popWait
+
+    using Slot = typename Reclaimer<Segment>::Slot;   //thread slot of the reclamation policy
+
+    //segments with the batch API (pushBatch / popBatch are offered only on top of them)
+    static constexpr bool batched = requires(Segment* seg, T** items){
+        seg->pushBatch(items,size_t{1},0);
+        seg->popBatch(items,size_t{1},0);
+    };
+
+    //segments counting their slow path pushes and forced closes (see StarvingPush)
+    static constexpr bool hasPushStats = requires(const Segment* seg){ seg->getPushStats(); };
+    std::atomic<uint64_t> retiredSlowPushes{0};     //push statistics of the retired segments
+    std::atomic<uint64_t> retiredHelpedPushes{0};
+    std::atomic<uint64_t> retiredForcedCloses{0};
+
+    SegmentPool<Segment> pool;  //retired segments ready to be reused (declared before HP: HP hands segments over to it)
+    std::shared_ptr<Domain> domain;
+    Domain& HP;  //Hazard Pointers (or the chosen policy) to ensure no memory leaks on concurrent allocations and deletions
 
     //Deprecated function
     inline T* dequeueAfterNextLinked(Segment* lhead, int tid) {
         return lhead->pop(tid);
     }
 
+    //allocates a segment: cells and segment in a single block when the segment supports it
+    inline Segment* newSegment(uint64_t start) {
+        if constexpr (Segment::singleBlock)
+            return new (detail::RingCells{Segment::cellsFor(size)}) Segment(size,0,start);
+        else
+            return new Segment(size,0,start);
+    }
+
+    /*
+        returns a new empty segment starting from the given index:
+        reuses a segment from the pool if available, otherwise allocates it
+    */
+    inline Segment* allocSegment(uint64_t start, const Slot& slot) {
+        Segment* seg = pool.get();
+        if(seg == nullptr)
+            seg = newSegment(start);
+        else
+            seg->init(start);
+        if constexpr (requires{ HP.onAlloc(seg,slot); })
+            HP.onAlloc(seg,slot);   //policies that track the lifetime of the segments
+        return seg;
+    }
+
+    //keeps the push statistics of the segment before handing it to the reclaimer
+    inline void retireSegment(Segment* seg, const Slot& slot) {
+        if constexpr (hasPushStats){
+            const PushStats stats = seg->getPushStats();
+            retiredSlowPushes.fetch_add(stats.slowPushes,std::memory_order_relaxed);
+            retiredHelpedPushes.fetch_add(stats.helpedPushes,std::memory_order_relaxed);
+            retiredForcedCloses.fetch_add(stats.forcedCloses,std::memory_order_relaxed);
+        }
+        HP.retire(seg,slot);
+    }
+
 public:
 
+    /*
+        threads: number of thread slots (tids / registered threads), it can exceed MAX_THREADS
+    */
     LinkedRingQueue(size_t SegmentLength, size_t threads = MAX_THREADS):
-    size{SegmentLength},
     maxThreads{threads},
-    HP(2,maxThreads)    
+    size{SegmentLength},
+    domain{std::make_shared<Domain>(2,maxThreads,[this](Segment* seg){ pool.put(seg); })},
+    HP{*domain}
     {
-#ifndef DISABLE_HAZARD
-    assert(maxThreads <= MAX_THREADS); //assertion to assure no SIGSEGV when accessing the HP matrix
-#endif
-        Segment* sentinel = new Segment(SegmentLength);
+        Segment* sentinel = newSegment(0);
         head.store(sentinel, std::memory_order_relaxed);
         tail.store(sentinel, std::memory_order_relaxed);
     }
 
     /*
-        When the queue goes out of scope:
-        1. empty the current segment (ensures no memory leaks on elements)
-        2. delete the current segment
+        Queue attached to a reclamation domain shared with other queues (see makeDomain):
+        a thread keeps one hazard row and one retired list for all of them, and a scan
+        reclaims the segments retired by any queue of the domain.
+        Reclaimed segments are deleted instead of going back to the pool, since the queue
+        that retired them may already be gone
+    */
+    LinkedRingQueue(size_t SegmentLength, std::shared_ptr<Domain> sharedDomain):
+    maxThreads{static_cast<size_t>(sharedDomain->getMaxThreads())},
+    size{SegmentLength},
+    domain{std::move(sharedDomain)},
+    HP{*domain}
+    {
+        Segment* sentinel = newSegment(0);
+        head.store(sentinel, std::memory_order_relaxed);
+        tail.store(sentinel, std::memory_order_relaxed);
+    }
+
+    //reclamation domain to share among the queues of this type (tids / handles are per domain)
+    static std::shared_ptr<Domain> makeDomain(size_t threads = MAX_THREADS) {
+        return std::make_shared<Domain>(2,threads);
+    }
 
-        The destructor cascades on the next segments
+    /*
+        When the queue goes out of scope deletes the linked segments
+        (each segment empties itself on deletion).
+        No thread slot is used: the domain may be shared with queues still in use
     */
     ~LinkedRingQueue() {
-        while(pop(0) != nullptr);
-        delete head.load();
+        Segment* seg = head.load();
+        while(seg != nullptr){
+            Segment* next = seg->next.load();
+            delete seg;
+            seg = next;
+        }
     }
 
     static string className(bool padding = true){
-        return "Linked" + Segment::className(padding);
+        return "Linked" + Segment::className(padding) + Reclaimer<Segment>::className();
+    }
+
+    //memory taken by every slot of a segment (segments reporting it)
+    static constexpr size_t bytesPerSlot() requires requires{ Segment::bytesPerSlot(); } {
+        return Segment::bytesPerSlot();
     }
 
+private:
     /*
         pushes a new element into the queue. The operation always succeds
         (if current segment is full then allocates another one)
 
         Note: It uses Hazard Pointer to protect access to segments (ensures no memory leaks on concurrent eliminations)
     */
-    __attribute__((used,always_inline)) void push(T* item, int tid){
+    __attribute__((always_inline)) void pushImpl(T* item, const Slot& slot){
+        const int tid = slot.tid;
         if(item == nullptr)
             throw invalid_argument(className(false) + "ERROR push(): item cannot be null");
         
-        Segment *ltail = HP.protect(kHpTail,tail.load(),tid);
+        Segment *ltail = HP.protect(kHpTail,tail,slot);
         while(true) {
-#ifndef DISABLE_HAZARD
-            Segment *ltail2 = tail.load();
-            if(ltail2 != ltail){
-                ltail = HP.protect(kHpTail,ltail2,tid); //if current segment has been updated then changes
-                continue;
+            if constexpr (Reclaimer<Segment>::needsValidation) {
+                Segment *ltail2 = tail.load();
+                if(ltail2 != ltail){
+                    ltail = HP.protect(kHpTail,ltail2,slot); //if current segment has been updated then changes
+                    continue;
+                }
             }
-#endif  
             Segment *lnext = ltail->next.load();
             if(lnext != nullptr) { //If a new segment exists
                 tail.compare_exchange_strong(ltail, lnext)?
-                    ltail = HP.protect(kHpTail, lnext,tid) //update protection on the new Segment
+                    ltail = HP.protect(kHpTail, lnext,slot) //update protection on the new Segment
                 : 
-                    ltail = HP.protect(kHpTail,tail.load(),tid); //someone else already updated the shared queeu
+                    ltail = HP.protect(kHpTail,tail,slot); //someone else already updated the shared queeu
                 continue; //try push on the new segment
             }
 
             if(ltail->push(item,tid)) {
-                HP.clear(kHpTail,tid); //if succesful insertion then exits updating the HP matrix
+                HP.clear(kHpTail,slot); //if succesful insertion then exits updating the HP matrix
                 break;
             }
 
             //if failed insertion then current segment is full (allocate a new one)
-            Segment* newTail = new Segment(size,0,ltail->getTailIndex());
+            Segment* newTail = allocSegment(ltail->getTailIndex(),slot);
             newTail->push(item,tid);
 
             Segment* nullSegment = nullptr;
             if(ltail->next.compare_exchange_strong(nullSegment,newTail)){ //if CAS succesful then the queue has ben updated
                 tail.compare_exchange_strong(ltail,newTail);
-                HP.clear(kHpTail,tid); //clear protection on the tail
+                HP.clear(kHpTail,slot); //clear protection on the tail
                 break;
             } 
             else 
-                delete newTail; //delete the segment since the modification has been unsuccesful
+                pool.put(newTail); //recycle the segment since the modification has been unsuccesful
+
+            ltail = HP.protect(kHpTail,nullSegment,slot);    //update protection on hte current new segment
+        }
+        detail::asymmetricLightBarrier();   //the item must be visible before checking for waiters (heavy side in waitUntil)
+        notEmpty.notify();  //a load if no consumer is parked
+    }
+
+    /*
+        pushes n elements into the queue with batched ticket reservations.
+        Each segment accepts as many items as it can with a single fetch_add,
+        if the segment closes partway through the rest is carried into the next one.
+        The operation always succeeds (allocates new segments when needed)
+    */
+    void pushBatchImpl(T** items, size_t n, const Slot& slot){
+        const int tid = slot.tid;
+        for(size_t i = 0; i < n; i++){
+            if(items[i] == nullptr)
+                throw invalid_argument(className(false) + "ERROR pushBatch(): items cannot be null");
+        }
+
+        size_t done = 0;
+        Segment *ltail = HP.protect(kHpTail,tail,slot);
+        while(done < n) {
+            if constexpr (Reclaimer<Segment>::needsValidation) {
+                Segment *ltail2 = tail.load();
+                if(ltail2 != ltail){
+                    ltail = HP.protect(kHpTail,ltail2,slot);
+                    continue;
+                }
+            }
+            Segment *lnext = ltail->next.load();
+            if(lnext != nullptr) {
+                tail.compare_exchange_strong(ltail, lnext)?
+                    ltail = HP.protect(kHpTail, lnext,slot)
+                :
+                    ltail = HP.protect(kHpTail,tail,slot);
+                continue;
+            }
+
+            done += ltail->pushBatch(items + done, n - done, tid);
+            if(done == n)
+                break;
+
+            //current segment has been closed: carry the rest into a new segment
+            Segment* newTail = allocSegment(ltail->getTailIndex(),slot);
+            size_t carried = newTail->pushBatch(items + done, n - done, tid);
 
-            ltail = HP.protect(kHpTail,nullSegment,tid);    //update protection on hte current new segment
+            Segment* nullSegment = nullptr;
+            if(ltail->next.compare_exchange_strong(nullSegment,newTail)){
+                done += carried;
+                tail.compare_exchange_strong(ltail,newTail);
+                ltail = HP.protect(kHpTail,tail,slot);
+                continue;
+            }
+            else
+                pool.put(newTail); //the items are pushed again on the segment appended by someone else
+
+            ltail = HP.protect(kHpTail,nullSegment,slot);
         }
+        HP.clear(kHpTail,slot);
+        detail::asymmetricLightBarrier();
+        if(n != 0)
+            notEmpty.notifyAll();
     }
 
     /*
@@ -125,16 +277,17 @@ public:
 
     return: pointer to next element or nullptr
      */
-    __attribute__((used,always_inline)) T* pop(int tid) {
-        Segment* lhead = HP.protect(kHpHead,head.load(),tid);   //protect the current segment
+    __attribute__((always_inline)) T* popImpl(const Slot& slot) {
+        const int tid = slot.tid;
+        Segment* lhead = HP.protect(kHpHead,head,slot);   //protect the current segment
         while(true){
-#ifndef DISABLE_HAZARD
-            Segment *lhead2 = head.load();
-            if(lhead2 != lhead){
-                lhead = HP.protect(kHpHead,lhead2,tid);
-                continue;
-            }           
-#endif
+            if constexpr (Reclaimer<Segment>::needsValidation) {
+                Segment *lhead2 = head.load();
+                if(lhead2 != lhead){
+                    lhead = HP.protect(kHpHead,lhead2,slot);
+                    continue;
+                }           
+            }
             T* item = lhead->pop(tid); //pop on the current segment
             if (item == nullptr) {
                 Segment* lnext = lhead->next.load(); //if unsuccesful pop then try to load next semgnet
@@ -142,35 +295,196 @@ public:
                     item = lhead->pop(tid); //DequeueAfterNextLinked(lnext)
                     if (item == nullptr) {
                         if (head.compare_exchange_strong(lhead, lnext)) {   //changes shared head pointer
-                            HP.retire(lhead, tid); //tries to deallocate current segment
-                            lhead = HP.protect(kHpHead, lnext, tid); //protect new segment
+                            retireSegment(lhead, slot); //tries to deallocate current segment
+                            lhead = HP.protect(kHpHead, lnext, slot); //protect new segment
                         } else {
-                            lhead = HP.protect(kHpHead, lhead, tid);
+                            lhead = HP.protect(kHpHead, lhead, slot);
                         }
                         continue;
                     }
                 }
             }
 
-            HP.clear(kHpHead,tid); //after pop removes protection on the current segment
+            HP.clear(kHpHead,slot); //after pop removes protection on the current segment
             return item;
         }
     }
 
     /*
-        Returns current size of the queue
+    Batched pop: drains up to max elements, moving on to the next segment
+    when the current one is exhausted.
+
+    return: number of elements written into out
     */
-    size_t length(int tid) {
-        Segment *lhead = HP.protect(kHpHead,head,tid);
-        Segment *ltail = HP.protect(kHpTail,tail,tid);
+    size_t popBatchImpl(T** out, size_t max, const Slot& slot) {
+        const int tid = slot.tid;
+        size_t done = 0;
+        Segment* lhead = HP.protect(kHpHead,head,slot);
+        while(done < max){
+            if constexpr (Reclaimer<Segment>::needsValidation) {
+                Segment *lhead2 = head.load();
+                if(lhead2 != lhead){
+                    lhead = HP.protect(kHpHead,lhead2,slot);
+                    continue;
+                }
+            }
+            done += lhead->popBatch(out + done, max - done, tid);
+            if(done == max)
+                break;
+
+            Segment* lnext = lhead->next.load();
+            if(lnext == nullptr)
+                break;  //no more segments
+
+            size_t late = lhead->popBatch(out + done, max - done, tid);  //items pushed before the segment was closed
+            done += late;
+            if(late != 0)
+                continue;
+
+            if (head.compare_exchange_strong(lhead, lnext)) {
+                retireSegment(lhead, slot);
+                lhead = HP.protect(kHpHead, lnext, slot);
+            } else {
+                lhead = HP.protect(kHpHead, lhead, slot);
+            }
+        }
+
+        HP.clear(kHpHead,slot);
+        return done;
+    }
+
+    //spins on pop, then parks until a push (or the timeout)
+    template<class Rep, class Period>
+    T* popWaitImpl(const Slot& slot, const std::chrono::duration<Rep,Period> timeout) {
+        return waitUntil(notEmpty,waitDeadline(timeout),[this,&slot](){ return popImpl(slot); });
+    }
+
+    size_t lengthImpl(const Slot& slot) {
+        Segment *lhead = HP.protect(kHpHead,head,slot);
+        Segment *ltail = HP.protect(kHpTail,tail,slot);
         uint64_t t = ltail->getTailIndex();
         uint64_t h = lhead->getHeadIndex();
-        HP.clear(tid);
+        HP.clear(slot);
         return t > h ? t - h : 0;
     }
 
+public:
+    /*
+        RAII registration: assigns a free thread slot (released when the handle
+        goes out of scope). Operations on a handle do not take a tid.
+        Do not mix handles and caller-supplied tids on the same queue.
+    */
+    using Handle = ThreadHandle<Reclaimer<Segment>>;
+
+    Handle registerThread() {
+        return Handle(HP);
+    }
+
+    //the handle is valid on every queue attached to the domain
+    static Handle registerThread(Domain& sharedDomain) {
+        return Handle(sharedDomain);
+    }
+
+    /*
+        Operations with a caller-supplied tid (0 <= tid < maxThreads)
+    */
+    __attribute__((used,always_inline)) void push(T* item, int tid) {
+        pushImpl(item,HP.slot(tid));
+    }
+
+    void pushBatch(T** items, size_t n, int tid) requires batched {
+        pushBatchImpl(items,n,HP.slot(tid));
+    }
+
+    __attribute__((used,always_inline)) T* pop(int tid) {
+        return popImpl(HP.slot(tid));
+    }
+
+    size_t popBatch(T** out, size_t max, int tid) requires batched {
+        return popBatchImpl(out,max,HP.slot(tid));
+    }
+
+    /*
+        Blocking pop: waits for an item up to timeout (default: no timeout),
+        the consumer spins briefly and then sleeps on a futex.
+        return: nullptr on timeout
+    */
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    T* popWait(int tid, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) {
+        return popWaitImpl(HP.slot(tid),timeout);
+    }
+
+    //Returns current size of the queue
+    size_t length(int tid) {
+        return lengthImpl(HP.slot(tid));
+    }
+
+    /*
+        Operations of a registered thread
+    */
+    inline void push(T* item, const Handle& h) {
+        pushImpl(item,h.get());
+    }
+
+    inline void pushBatch(T** items, size_t n, const Handle& h) requires batched {
+        pushBatchImpl(items,n,h.get());
+    }
+
+    inline T* pop(const Handle& h) {
+        return popImpl(h.get());
+    }
+
+    inline size_t popBatch(T** out, size_t max, const Handle& h) requires batched {
+        return popBatchImpl(out,max,h.get());
+    }
+
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    inline T* popWait(const Handle& h, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) {
+        return popWaitImpl(h.get(),timeout);
+    }
+
+    inline size_t length(const Handle& h) {
+        return lengthImpl(h.get());
+    }
+
+    /*
+        Runs stall() while holding the protection on the head segment,
+        as a consumer descheduled in the middle of a pop would do.
+        Used by MemoryBenchmark to measure the memory pinned by stalled threads
+    */
+    template<typename F>
+    void stalledPop(int tid, F&& stall) {
+        const Slot slot = HP.slot(tid);
+        HP.protect(kHpHead,head,slot);
+        stall();
+        HP.clear(kHpHead,slot);
+    }
+
+    //segment pool statistics (allocations served by the pool / by the allocator)
+    inline uint64_t getPoolHits() const { return pool.getHits(); }
+    inline uint64_t getPoolMisses() const { return pool.getMisses(); }
+
+    //hazard pointers scan statistics
+    inline ReclaimStats getReclaimStats() const { return HP.getStats(); }
+
+    /*
+        Slow path pushes and forced closes of the retired and of the linked segments.
+        The linked segments are not protected: call it when no operation is running
+    */
+    PushStats getPushStats() const requires hasPushStats {
+        PushStats stats{retiredSlowPushes.load(),retiredHelpedPushes.load(),retiredForcedCloses.load()};
+        for(Segment* seg = head.load(); seg != nullptr; seg = seg->next.load())
+            stats += seg->getPushStats();
+        return stats;
+    }
+
 };
 
+namespace detail{
+//white box access to the private members of the segments (defined by the unit tests only)
+template<class Segment> struct SegmentProbe;
+}
+
 /**
  * Superclass for queue segments
  */
@@ -181,7 +495,9 @@ protected:
     alignas(CACHE_LINE) std::atomic<uint64_t> head{0};
     alignas(CACHE_LINE) std::atomic<uint64_t> tail{0};
     alignas(CACHE_LINE) std::atomic<Segment*> next{nullptr};
-    alignas(CACHE_LINE) std::atomic<uint64_t> cluster{};   //most operations should be on the same cluster
+    //cluster mode resolved once, when the segment is constructed (not on every push / pop)
+    const bool clustered = getClusterMode() == ClusterMode::Cohort;
+    detail::ClusterCohort cohort;   //NUMA node owning the segment (ClusterMode::Cohort)
 
     /*
         The tail is:
@@ -256,25 +572,32 @@ protected:
         return getTailIndex() - 1;
     }
 
+    static inline uint64_t clusterNode(){
+        const int node = isNumaAvailable() ? getNumaNode() : 0;
+        return node < 0 ? 0 : static_cast<uint64_t>(node);
+    }
+
     /*
-    DEBUG: numa optimization to keep most operations in-cluster
+        NUMA optimization to keep most operations in-cluster (see ClusterCohort):
+        no-op unless ClusterMode::Cohort was selected when the segment was constructed
     */
 #ifndef DISABLE_NUMA
-    __attribute__((used,always_inline)) bool safeCluster(){
-        while(true){
-            uint64_t c = cluster.load();
-            if(c != getNumaNode()){
-                this_thread::sleep_for(std::chrono::microseconds(CLUSTER_TIMEOUT));
-                if(cluster.compare_exchange_strong(c,getNumaNode()))
-                    return true;
-            }
-        }
+    __attribute__((used,always_inline)) void safeCluster(){
+        if(clustered)
+            cohort.acquire(clusterNode());
     }
 #else
-    inline bool safeCluster(){return true;}
+    inline void safeCluster(){}
 #endif
 
 
 public:
-    friend class LinkedRingQueue<T,Segment>;   
+    //cells allocated after the segment object (see detail::SingleBlock)
+    static constexpr bool singleBlock = false;
+
+    //allocation / retirement eras (used by IntervalBasedReclamation)
+    uint64_t birthEra = 0;
+    uint64_t retireEra = 0;
+
+    template<class, class, template<typename> class> friend class LinkedRingQueue;
 };
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include <cstddef>  // For alignas
+#include <cstdint>
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+/*
+    Link embedded in the items of an intrusive MPSCQueue:
+    an item type deriving from MPSCHook is linked through its own hook
+    (no allocation per push). An item must be in one queue at a time.
+*/
+struct MPSCHook {
+    std::atomic<MPSCHook*> mpscNext{nullptr};
+};
+
+/*
+    Multi producer / single consumer node queue (D. Vyukov, intrusive version).
+
+    A push is one XCHG on the tail followed by the store that links the
+    previous node: producers never retry. The consumer owns the head and never
+    issues an RMW; it is wait-free but it can see the queue as empty while a
+    producer sits between the XCHG and the link (the item shows up once the
+    link is stored).
+    A stub node keeps the list non-empty, so the last item can be returned
+    to the caller: the stub is pushed again when the consumer reaches the tail.
+
+    Items not deriving from MPSCHook are wrapped in a node allocated by the push
+    and freed by the pop.
+    No counters are kept, so a push stays a single XCHG: length() walks the
+    linked nodes from the head and is for the consumer only (see ConsumerLengthQueues).
+*/
+template<typename T>
+class MPSCQueue {
+private:
+    static constexpr bool intrusive = std::is_base_of_v<MPSCHook,T>;
+
+    struct Node : MPSCHook {
+        T* item;
+    };
+
+    alignas(CACHE_LINE) std::atomic<MPSCHook*> tail;   //last node (producers)
+    alignas(CACHE_LINE) MPSCHook* head;                //first node (consumer only)
+    MPSCHook stub;
+
+    inline void link(MPSCHook* node){
+        node->mpscNext.store(nullptr,std::memory_order_relaxed);
+        MPSCHook* prev = tail.exchange(node,std::memory_order_acq_rel);
+        prev->mpscNext.store(node,std::memory_order_release);
+    }
+
+    /*
+        Unlinks the first node
+        return: the node or nullptr if the queue is empty (or a push is in flight)
+    */
+    MPSCHook* unlink(){
+        MPSCHook* first = head;
+        MPSCHook* next = first->mpscNext.load(std::memory_order_acquire);
+        if(first == &stub){
+            if(next == nullptr)
+                return nullptr;
+            head = next;
+            first = next;
+            next = next->mpscNext.load(std::memory_order_acquire);
+        }
+        if(next != nullptr){
+            head = next;
+            return first;
+        }
+        if(first != tail.load(std::memory_order_acquire))
+            return nullptr;     //a producer swapped the tail but has not linked its node yet
+        link(&stub);            //first is the last node: the stub takes its place
+        next = first->mpscNext.load(std::memory_order_acquire);
+        if(next != nullptr){
+            head = next;
+            return first;
+        }
+        return nullptr;
+    }
+
+public:
+    MPSCQueue([[maybe_unused]] size_t size, [[maybe_unused]] size_t threads = 128):
+    tail{&stub},
+    head{&stub}
+    {}
+
+    ~MPSCQueue(){
+        if constexpr (!intrusive){
+            while(pop(0) != nullptr);
+        }
+    }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    static std::string className([[maybe_unused]] bool padding = true){
+        return "MPSCQueue";
+    }
+
+    //any producer
+    __attribute__((used,always_inline)) void push(T* item, [[maybe_unused]] const int tid = 0){
+        if(item == nullptr)
+            throw std::invalid_argument(className(false) + " ERROR push(): item cannot be null");
+        if constexpr (intrusive)
+            link(item);
+        else
+            link(new Node{{},item});
+    }
+
+    //consumer only
+    __attribute__((used,always_inline)) T* pop([[maybe_unused]] const int tid = 0){
+        MPSCHook* node = unlink();
+        if(node == nullptr)
+            return nullptr;
+        if constexpr (intrusive)
+            return static_cast<T*>(node);
+        else {
+            T* item = static_cast<Node*>(node)->item;
+            delete static_cast<Node*>(node);
+            return item;
+        }
+    }
+
+    //consumer only (pop frees the nodes it walks): O(length), a push not yet linked is not counted
+    size_t length([[maybe_unused]] const int tid = 0) const {
+        size_t count = 0;
+        for(const MPSCHook* node = head; node != nullptr; node = node->mpscNext.load(std::memory_order_acquire)){
+            if(node != &stub) ++count;
+        }
+        return count;
+    }
+};
@@ -1,9 +1,12 @@
 #pragma once
 #include <cstddef>  // For alignas
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include <queue>
 #include <atomic>
 #include <string>
+#include "EventCount.hpp"   //WAIT_SPIN, waitDeadline
 
 
 template<typename T, bool bounded>
@@ -12,6 +15,8 @@ private:
     std::queue<T*>   queue;
     mutex            mux;   
     size_t           size;
+    condition_variable  notFull;            //producers parked by pushWait
+    size_t              parkedProducers = 0;    //protected by mux
 
 
 public:
@@ -40,14 +45,45 @@ public:
 
     __attribute__((used,always_inline)) T* pop([[maybe_unused]] const int tid = 0){
         T* item;
-        lock_guard<mutex> lock(mux);
-        if(!queue.empty()){
-            item = queue.front();  //still need to know waht happens if queue it's empty
-            queue.pop();
-        } else item = nullptr;
+        bool wake = false;
+        {
+            lock_guard<mutex> lock(mux);
+            if(!queue.empty()){
+                item = queue.front();  //still need to know waht happens if queue it's empty
+                queue.pop();
+                wake = parkedProducers != 0;
+            } else item = nullptr;
+        }
+        if(wake)
+            notFull.notify_one();
         return item;
     }
 
+    /*
+        Blocking push of the bounded queue (backpressure): tries WAIT_SPIN times,
+        then waits on the condition variable until a pop (or the timeout, default: no timeout)
+        return: false on timeout
+    */
+    template<class Rep = std::chrono::nanoseconds::rep, class Period = std::nano>
+    bool pushWait(T* item, const int tid = 0, const std::chrono::duration<Rep,Period> timeout = std::chrono::nanoseconds::max()) requires bounded {
+        for(int iSpin = 0; iSpin < WAIT_SPIN; iSpin++){
+            if(push(item,tid))
+                return true;
+        }
+        const auto deadline = waitDeadline(timeout);
+        unique_lock<mutex> lock(mux);
+        while(queue.size() >= size){
+            ++parkedProducers;
+            const cv_status status = (deadline == chrono::steady_clock::time_point::max())?
+                (notFull.wait(lock), cv_status::no_timeout) : notFull.wait_until(lock,deadline);
+            --parkedProducers;
+            if(status == cv_status::timeout && queue.size() >= size)
+                return false;
+        }
+        queue.push(item);
+        return true;
+    }
+
 };
 
 template<typename T,bool bounded=true>
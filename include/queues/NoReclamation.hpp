@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <functional>
+#include <memory>
+#include "ReclaimStats.hpp"
+#include "ThreadHandle.hpp"
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+/*
+    Reclamation policy that never frees memory while the queue is alive:
+    retired pointers are only collected (per thread, no synchronization)
+    and deleted when the queue is destroyed.
+
+    It is the baseline to measure the cost of the other policies
+    (previously obtained by compiling with DISABLE_HAZARD)
+*/
+template<typename T>
+class NoReclamation {
+public:
+    static const int MAX_THREADS = 256;     //default number of thread slots
+    static constexpr bool needsValidation = false;
+
+private:
+    struct alignas(CACHE_LINE) Record {
+        std::atomic<bool> active{false};    //slot in use by a thread
+        std::vector<T*> retired;
+    };
+
+    const int maxThreads;
+    std::unique_ptr<Record[]> records;  //one record per thread slot (allocated at runtime)
+
+public:
+    //thread slot: index and cached pointer to the thread's record
+    struct Slot {
+        int tid;
+        Record* rec;
+    };
+
+    NoReclamation(  [[maybe_unused]] int maxHPs = 0,
+                    int maxThreads = MAX_THREADS,
+                    [[maybe_unused]] std::function<void(T*)> reclaim = nullptr):
+    maxThreads{maxThreads},
+    records{new Record[maxThreads]} {}
+
+    ~NoReclamation(){
+        for(int iThread = 0; iThread < maxThreads; iThread++){
+            for(T* ptr : records[iThread].retired)
+                delete ptr;
+        }
+    }
+
+    inline Slot slot(const int tid){
+        Record& rec = records[tid];
+        useSlot(rec);
+        return Slot{tid,&rec};
+    }
+
+    Slot acquire(){
+        const int tid = claimSlot([this](int i) -> Record& { return records[i]; },maxThreads);
+        return Slot{tid,&records[tid]};
+    }
+
+    void release(const Slot& s){
+        s.rec->active.store(false,std::memory_order_release);
+    }
+
+    void clear(const Slot&){}
+    void clear(const int, const Slot&){}
+    T* protect(const int, const std::atomic<T*>& atom, const Slot&){return atom.load();}
+    T* protect(const int, T* ptr, const Slot&){return ptr;}
+    T* protectRelease(const int, T* ptr, const Slot&){return ptr;}
+
+    void retire(T* ptr, const Slot& s){
+        s.rec->retired.push_back(ptr);
+    }
+
+    inline int getMaxThreads() const {
+        return maxThreads;
+    }
+
+    ReclaimStats getStats() const {return ReclaimStats{};}
+
+    static std::string className(){
+        return "/NoReclaim";
+    }
+};
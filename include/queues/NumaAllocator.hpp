@@ -0,0 +1,220 @@
+#pragma once
+
+#include <new>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+#include "numa_support.hpp"
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+/*
+    Placement of the cell arrays of the ring segments (CRQueue, PRQueue, MTQueue)
+
+    FirstTouch: plain allocation, pages land on the node of the first thread
+                writing them (the thread running init)
+    Local:      node of the allocating thread (the producer appending a new segment)
+    Interleave: pages interleaved over every node
+    Bind:       node SEGMENT_NUMA_NODE
+
+    Every policy other than FirstTouch needs libnuma: with DISABLE_NUMA (or when
+    NUMA is not available at runtime) they fall back to FirstTouch.
+
+    MACROS: SEGMENT_NUMA_POLICY (default FirstTouch)
+            SEGMENT_NUMA_NODE   (node of the Bind policy)
+*/
+enum class NumaPolicy { FirstTouch, Local, Interleave, Bind };
+
+#ifndef SEGMENT_NUMA_POLICY
+#define SEGMENT_NUMA_POLICY FirstTouch
+#endif
+
+#ifndef SEGMENT_NUMA_NODE
+#define SEGMENT_NUMA_NODE 0
+#endif
+
+namespace detail{
+
+/*
+    Owning array of Cell placed following a NumaPolicy.
+    The cells are default constructed: the segments initialize them in init()
+*/
+template<class Cell>
+class NumaArray {
+private:
+    Cell* cells = nullptr;
+    size_t count = 0;
+    bool numaAllocated = false;
+
+    static constexpr std::align_val_t alignment{alignof(Cell)};
+
+    void release() {
+        if(cells == nullptr) return;
+        for(size_t i = 0; i < count; i++)
+            cells[i].~Cell();
+#ifndef DISABLE_NUMA
+        if(numaAllocated)
+            numa_free(cells,count * sizeof(Cell));
+        else
+#endif
+            ::operator delete(cells,alignment);
+        cells = nullptr;
+    }
+
+public:
+    static constexpr NumaPolicy defaultPolicy = NumaPolicy::SEGMENT_NUMA_POLICY;
+
+    NumaArray() = default;
+
+    NumaArray(size_t n, NumaPolicy policy = defaultPolicy, int node = SEGMENT_NUMA_NODE): count{n} {
+        void* memory = nullptr;
+#ifndef DISABLE_NUMA
+        if(policy != NumaPolicy::FirstTouch && isNumaAvailable()){
+            const size_t bytes = n * sizeof(Cell);
+            switch(policy){
+                case NumaPolicy::Local:         memory = numa_alloc_local(bytes);           break;
+                case NumaPolicy::Interleave:    memory = numa_alloc_interleaved(bytes);     break;
+                case NumaPolicy::Bind:          memory = numa_alloc_onnode(bytes,node);     break;
+                default:                                                                    break;
+            }
+            if(memory == nullptr)
+                throw std::bad_alloc();
+            numaAllocated = true;   //page aligned
+        }
+#else
+        (void)policy;
+        (void)node;
+#endif
+        if(memory == nullptr)
+            memory = ::operator new(n * sizeof(Cell),alignment);
+        cells = static_cast<Cell*>(memory);
+        for(size_t i = 0; i < n; i++)
+            new (&cells[i]) Cell();
+    }
+
+    ~NumaArray() { release(); }
+
+    NumaArray(const NumaArray&) = delete;
+    NumaArray& operator=(const NumaArray&) = delete;
+
+    NumaArray(NumaArray&& other) noexcept:
+    cells{std::exchange(other.cells,nullptr)},
+    count{std::exchange(other.count,0)},
+    numaAllocated{std::exchange(other.numaAllocated,false)} {}
+
+    NumaArray& operator=(NumaArray&& other) noexcept {
+        if(this != &other){
+            release();
+            cells = std::exchange(other.cells,nullptr);
+            count = std::exchange(other.count,0);
+            numaAllocated = std::exchange(other.numaAllocated,false);
+        }
+        return *this;
+    }
+
+    inline Cell& operator[](size_t i) const { return cells[i]; }
+    inline Cell* data() const { return cells; }
+    inline size_t size() const { return count; }
+    inline bool onNuma() const { return numaAllocated; }
+};
+
+/*
+    Cell array embedded in the segment object (compile time ring size N): no
+    second allocation and no pointer to follow, placed with the segment itself.
+    Same interface as NumaArray
+*/
+template<class Cell, size_t N>
+class EmbeddedArray {
+private:
+    mutable std::array<Cell,N> cells;
+
+public:
+    explicit EmbeddedArray([[maybe_unused]] size_t n = N) {}
+
+    inline Cell& operator[](size_t i) const { return cells[i]; }
+    inline Cell* data() const { return cells.data(); }
+    static constexpr size_t size() { return N; }
+    static constexpr bool onNuma() { return false; }
+};
+
+
+/*
+    Single block segments: the cells follow the segment object in the same
+    allocation, so a segment costs one allocator call and the address of the
+    cells is computed from the address of the segment instead of being loaded.
+
+    Segments opt in by inheriting SingleBlock (class-specific operator new/delete)
+    and are allocated with new (RingCells{n}) Segment(...); they find their cells
+    with trailingCells<Cell>(this). The cells must be trivially destructible.
+*/
+struct RingCells {
+    size_t count;
+};
+
+template<class Segment, class Cell>
+constexpr size_t trailingOffset() {
+    return (sizeof(Segment) + alignof(Cell) - 1) / alignof(Cell) * alignof(Cell);
+}
+
+template<class Cell, class Segment>
+inline Cell* trailingCells(const Segment* segment) {
+    return reinterpret_cast<Cell*>(reinterpret_cast<uintptr_t>(segment) + trailingOffset<Segment,Cell>());
+}
+
+template<class Cell, size_t Alignment>
+struct SingleBlock {
+    static_assert(std::is_trivially_destructible_v<Cell>,"the trailing cells are never destroyed");
+    static constexpr std::align_val_t alignment{Alignment > alignof(Cell) ? Alignment : alignof(Cell)};
+
+    //bytes is sizeof(Segment): the cells start at trailingOffset
+    static void* operator new(size_t bytes, RingCells cells) {
+        const size_t offset = (bytes + alignof(Cell) - 1) / alignof(Cell) * alignof(Cell);
+        void* block = ::operator new(offset + cells.count * sizeof(Cell),alignment);
+        for(size_t i = 0; i < cells.count; i++)
+            new (static_cast<char*>(block) + offset + i * sizeof(Cell)) Cell();
+        return block;
+    }
+
+    static void* operator new(size_t bytes) {
+        return ::operator new(bytes,alignment);
+    }
+
+    static void operator delete(void* block) {
+        ::operator delete(block,alignment);
+    }
+
+    //called if the constructor of the segment throws
+    static void operator delete(void* block, [[maybe_unused]] RingCells cells) {
+        ::operator delete(block,alignment);
+    }
+};
+
+//base of the segments not using a single block
+struct MultiBlock {};
+
+//single block only for the FirstTouch policy (the block comes from operator new)
+template<bool enabled, class Cell>
+inline constexpr bool useSingleBlock = enabled && NumaArray<Cell>::defaultPolicy == NumaPolicy::FirstTouch;
+
+template<bool enabled, class Cell>
+using SingleBlockIf = std::conditional_t<useSingleBlock<enabled,Cell>,SingleBlock<Cell,CACHE_LINE>,MultiBlock>;
+
+//placeholder of the cell array of the single block segments
+struct TrailingArray {
+    explicit TrailingArray([[maybe_unused]] size_t n) {}
+};
+
+/*
+    Cells of a ring of N cells (0: size chosen at runtime, see RingSize):
+    embedded in the segment, trailing the segment (single block) or in a NumaArray
+*/
+template<class Cell, size_t N, bool trailing = false>
+using RingArray = std::conditional_t<N != 0, EmbeddedArray<Cell,N>,
+                                     std::conditional_t<trailing, TrailingArray, NumaArray<Cell>>>;
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+#include "ShardedQueue.hpp"
+#include "numa_support.hpp"
+
+/*
+    NUMA shard selection (Select policy of ShardedQueue): one shard per NUMA node.
+
+    Producers push on the queue of the node they are running on, consumers
+    drain their local queue first and steal from the remote nodes (next node
+    first) only when it is empty, so most cells and segments are only touched
+    by threads of one node. Unlike the cohort cluster mode of the segments
+    (ClusterMode::Cohort) no thread ever waits for another node.
+
+    The order is FIFO per node only: items of a producer that migrates to
+    another node may be popped out of order.
+    With DISABLE_NUMA or a single node there is a single shard and the queue
+    is the inner queue (FIFO).
+
+    Node: node of the calling thread (getNumaNode, replaceable to emulate nodes)
+*/
+template<int (*Node)() = getNumaNode>
+class NumaNodeShard {
+private:
+    const size_t nodes;
+
+    inline size_t localNode() const {
+        if(nodes == 1) return 0;
+        const int node = Node();
+        return node < 0 ? 0 : static_cast<size_t>(node) % nodes;
+    }
+
+public:
+    static constexpr bool sizeHints = false;
+
+    NumaNodeShard(size_t nodeCount, [[maybe_unused]] size_t threads): nodes{nodeCount} {}
+
+    static size_t defaultShards() { return getNumaNodes(); }
+
+    static std::string prefix() { return "Numa"; }
+
+    inline size_t home([[maybe_unused]] const int tid) const { return localNode(); }
+
+    template<class Hint>
+    inline size_t pop([[maybe_unused]] const int tid, Hint&&) const { return localNode(); }
+};
+
+template<typename T, template<typename> class Q>
+using NumaShardedQueue = ShardedQueue<T,Q,NumaNodeShard<>>;
+
+/*
+    Declare aliases for the NUMA sharded queues
+*/
+template<typename T>
+using NumaLCRQueue = NumaShardedQueue<T,LCRQueue>;
+
+template<typename T>
+using NumaLPRQueue = NumaShardedQueue<T,LPRQueue>;
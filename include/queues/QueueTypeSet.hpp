@@ -2,16 +2,56 @@
 
 #include "TemplateSet.hpp"
 
-//TODO: Add fastflow queue Implementation
-
 #include "LCRQ.hpp"
+#include "CompactCRQ.hpp"
 #include "LPRQ.hpp"
+#include "LSCQ.hpp"
 #include "FAArray.hpp"
-//Fastflow Queue
+#include "SPSCQueue.hpp"     //Fastflow (uSPSC) Queue
+#include "MPSCQueue.hpp"
+#include "LMPSCQ.hpp"
+#include "WFQueue.hpp"
+#include "ShardedQueue.hpp"
+#include "NumaQueue.hpp"
+#include "InlineQueue.hpp"
 #include "LMTQ.hpp"
 #include "MuxQueue.hpp"
 
 
-using UnboundedQueues   = TemplateSet<FAAQueue,LCRQueue,LPRQueue,LinkedMuxQueue>;
-using BoundedQueues     = TemplateSet<BoundedCRQueue,BoundedPRQueue,BoundedMuxQueue,BoundedMTQueue>;
-using Queues            = UnboundedQueues::Cat<BoundedQueues>;
\ No newline at end of file
+using UnboundedQueues   = TemplateSet<FAAQueue,LCRQueue,LPRQueue,LSCQueue,LinkedMuxQueue,LinkedSPSCQueue,MPSCQueue,LMPSCQueue,WFQueue,
+                                      LMTQueue,LMTQueueNoBackoff,LMTQueueJitter,LMTQueueYield,
+                                      LCRQueueRemap,LPRQueueRemap,LMTQueueRemap,FAAQueueRemap,LCompactCRQueue,
+                                      LCRQueueFixed,LPRQueueFixed,LMTQueueFixed>;
+using BoundedQueues     = TemplateSet<BoundedCRQueue,BoundedPRQueue,BoundedMuxQueue,BoundedMTQueue,BoundedSPSCQueue,
+                                      BoundedMTQueueNoBackoff,BoundedMTQueueJitter,BoundedMTQueueYield,
+                                      BoundedCRQueueRemap,BoundedPRQueueRemap,BoundedMTQueueRemap,BoundedCompactCRQueue,
+                                      BoundedCRQueueFixed,BoundedPRQueueFixed,BoundedMTQueueFixed>;
+//Queues usable by one producer and one consumer only
+using SPSCQueues        = TemplateSet<LinkedSPSCQueue,BoundedSPSCQueue>;
+//Queues usable by a single consumer only
+using MPSCQueues        = TemplateSet<MPSCQueue,LMPSCQueue>::Cat<SPSCQueues>;
+//Queues whose length() can be called by the consumer only
+using ConsumerLengthQueues = TemplateSet<MPSCQueue>;
+//Relaxed FIFO queues (FIFO per shard only)
+using RelaxedQueues     = TemplateSet<ShardedLCRQueue,ShardedLPRQueue,NumaLCRQueue,NumaLPRQueue>;
+using Queues            = UnboundedQueues::Cat<BoundedQueues>::Cat<RelaxedQueues>;
+//MTQueue with every backoff policy of the CAS retries (see Backoff.hpp)
+using BackoffQueues     = TemplateSet<LMTQueueNoBackoff,LMTQueue,LMTQueueJitter,LMTQueueYield,
+                                      BoundedMTQueueNoBackoff,BoundedMTQueue,BoundedMTQueueJitter,BoundedMTQueueYield>;
+
+//Linked queues with every memory reclamation policy (HazardPointers, EBR, IBR, no reclamation)
+using ReclamationQueues = TemplateSet<  LCRQueue,LCRQueueEBR,LCRQueueIBR,LCRQueueNoReclaim,
+                                        LPRQueue,LPRQueueEBR,LPRQueueIBR,LPRQueueNoReclaim,
+                                        LSCQueue,LSCQueueEBR,LSCQueueIBR,LSCQueueNoReclaim,
+                                        FAAQueue,FAAQueueEBR,FAAQueueIBR,FAAQueueNoReclaim>;
+
+//Unpadded cells with the cache line remapping of the tickets (see detail::CellRemap)
+using RemappedQueues    = TemplateSet<LCRQueueRemap,LPRQueueRemap,LMTQueueRemap,FAAQueueRemap,
+                                      BoundedCRQueueRemap,BoundedPRQueueRemap,BoundedMTQueueRemap>;
+
+//Queues storing the values (Message, at most 8 bytes for InlineQueue) in their cells (see InlineQueue.hpp)
+using InlineQueues      = TemplateSet<InlineLCRQueue,InlineLMTQueue,InlineBoundedCRQueue,InlineBoundedMTQueue,BoundedValueQueue>;
+
+//Ring size fixed at compile time (4096 cells embedded in the segment, the runtime size is ignored)
+using FixedSizeQueues   = TemplateSet<LCRQueueFixed,LPRQueueFixed,LMTQueueFixed,
+                                      BoundedCRQueueFixed,BoundedPRQueueFixed,BoundedMTQueueFixed>;
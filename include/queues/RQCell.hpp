@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <cstddef>  // For alignas
+#include <cstdint>
 
 #ifndef CACHE_LINE
 #define CACHE_LINE 64
@@ -19,7 +20,7 @@
 
 namespace detail{
 
-inline bool isPowTwo(size_t x){
+constexpr bool isPowTwo(size_t x){
     return (x != 0 && (x & (x-1)) == 0);
 }
 
@@ -30,6 +31,48 @@ inline size_t nextPowTwo(size_t x){
     return p;
 }
 
+/*
+    Size of the ring and position of a ticket in the ring (ticket modulo the size).
+
+    N == 0: size chosen at runtime, rounded up to a power of 2 (masks) unless DISABLE_POW2
+    N > 0:  size fixed at compile time (the runtime size is ignored): constant mask if N
+            is a power of 2, constant modulo otherwise (DISABLE_POW2 doesn't apply)
+*/
+template<size_t N>
+struct RingSize {
+    static constexpr size_t size = N;
+
+    explicit RingSize([[maybe_unused]] size_t size_par) {}
+
+    //number of cells of a ring built with the given runtime size
+    static constexpr size_t cellsFor([[maybe_unused]] size_t size_par) { return N; }
+
+    static constexpr size_t position(uint64_t ticket) {
+        if constexpr (isPowTwo(N)) return ticket & (N - 1);
+        else return ticket % N;
+    }
+};
+
+template<>
+struct RingSize<0> {
+    const size_t size;
+#ifndef DISABLE_POW2
+    const size_t mask;  //Mask to execute the modulo operation
+
+    explicit RingSize(size_t size_par): size{nextPowTwo(size_par)}, mask{size - 1} {}
+
+    static inline size_t cellsFor(size_t size_par) { return nextPowTwo(size_par); }
+
+    inline size_t position(uint64_t ticket) const { return ticket & mask; }
+#else
+    explicit RingSize(size_t size_par): size{size_par} {}
+
+    static inline size_t cellsFor(size_t size_par) { return size_par; }
+
+    inline size_t position(uint64_t ticket) const { return ticket % size; }
+#endif
+};
+
 template<class, bool padded>
 struct CRQCell;
 
@@ -61,5 +104,83 @@ struct PlainCell<T,false>{
     std::atomic<T>          val;
 };
 
+/*
+    Cell storing a value inline (see BoundedValueQueue): the sequence number
+    idx tells the owner of the cell, val is accessed only by the owner
+*/
+template<class V, bool padded>
+struct ValueCell;
+
+template<class V>
+struct alignas(CACHE_LINE) ValueCell<V,true>{
+    std::atomic<uint64_t>   idx;
+    V                       val;
+};
+
+template<class V>
+struct ValueCell<V,false>{
+    std::atomic<uint64_t>   idx;
+    V                       val;
+};
+
+/*
+    Single word CRQ cell (see CompactCRQueue): unsafe bit, full bit and index
+    packed in 8 bytes, the payload is kept in a separate slot array
+*/
+struct CompactCell{
+    static constexpr uint64_t UNSAFE    = 1ull << 63;
+    static constexpr uint64_t FULL      = 1ull << 62;
+    static constexpr uint64_t INDEX     = FULL - 1;
+
+    std::atomic<uint64_t>   word;
+};
+static_assert(sizeof(CompactCell) == 8);
+
+/*
+    Position in the ring of the cell of a ring position (ticket modulo the ring size).
+
+    remapped: the ring is seen as rows = size / cellsPerLine cache lines and the
+    position p goes to line (p mod rows), slot (p / rows) of the line, so
+    consecutive tickets land on different cache lines while the cells stay packed
+    (a cache line is reused every rows tickets).
+    Identity if not remapped, with padded cells (one cell per line), with less
+    than two lines or if the ring size is not a multiple of the cells per line.
+*/
+template<class Cell, bool remapped>
+class CellRemap {
+private:
+    static constexpr size_t perLine = sizeof(Cell) >= CACHE_LINE ? 1 : CACHE_LINE / sizeof(Cell);
+    static constexpr size_t lineShift = __builtin_ctzll(perLine);
+
+    size_t rows = 0;        //0: identity
+    size_t rowMask = 0;     //rows is a power of two: shifts instead of divisions
+    size_t rowShift = 0;
+
+public:
+    explicit CellRemap(size_t ringSize) {
+        if constexpr (remapped && perLine > 1 && isPowTwo(perLine)){
+            if(ringSize % perLine == 0 && ringSize / perLine >= 2){
+                rows = ringSize / perLine;
+                if(isPowTwo(rows)){
+                    rowMask = rows - 1;
+                    rowShift = __builtin_ctzll(rows);
+                }
+            }
+        }
+    }
+
+    inline size_t operator()(size_t pos) const {
+        if constexpr (!remapped){
+            return pos;
+        } else {
+            if(rows == 0) return pos;
+            if(rowMask != 0) return ((pos & rowMask) << lineShift) | (pos >> rowShift);
+            return (pos % rows) * perLine + pos / rows;
+        }
+    }
+
+    inline bool active() const { return rows != 0; }
+};
+
 
 }
\ No newline at end of file
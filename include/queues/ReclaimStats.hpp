@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+    Reclamation statistics collected by the memory reclamation policies
+    (HazardPointers scans, EpochBasedReclamation epoch advances)
+*/
+struct ReclaimStats {
+    uint64_t scans      = 0;    //number of scans (or epoch advance attempts)
+    uint64_t scanNs     = 0;    //total time spent scanning (nanoseconds)
+    uint64_t reclaimed  = 0;    //number of pointers handed to the reclaimer
+
+    ReclaimStats& operator+=(const ReclaimStats& other){
+        scans       += other.scans;
+        scanNs      += other.scanNs;
+        reclaimed   += other.reclaimed;
+        return *this;
+    }
+};
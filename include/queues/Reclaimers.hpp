@@ -0,0 +1,23 @@
+#pragma once
+
+#include "HazardPointers.hpp"
+#include "EpochBasedReclamation.hpp"
+#include "IntervalBasedReclamation.hpp"
+#include "NoReclamation.hpp"
+
+/*
+    Memory reclamation policies for the linked queues (LinkedRingQueue, FAAArrayQueue):
+    - HazardPointers:           per pointer protection, scan of the hazards on retire
+    - EpochBasedReclamation:    one epoch announce per operation, batch frees on epoch advance
+    - IntervalBasedReclamation: era intervals, bounded memory with stalled threads (needs birth/retire eras)
+    - NoReclamation:            memory is freed only when the queue is destroyed
+
+    DISABLE_HAZARD selects NoReclamation as the default policy
+*/
+#ifndef DISABLE_HAZARD
+template<typename T>
+using DefaultReclaimer = HazardPointers<T>;
+#else
+template<typename T>
+using DefaultReclaimer = NoReclamation<T>;
+#endif
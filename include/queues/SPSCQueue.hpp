@@ -0,0 +1,249 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <stdexcept>
+#include <cstddef>  // For alignas
+#include <cstdint>
+#include "RQCell.hpp"       //nextPowTwo
+#include "SegmentPool.hpp"
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+/**
+ * MACROS:  DISABLE_POW2
+ */
+
+/*
+    Single producer / single consumer ring (FastFlow / Lamport style).
+
+    The producer owns the tail, the consumer owns the head: each index lives on its
+    own cache line together with the owner's cached copy of the other index.
+    A push reads the head only when the cached copy says the ring is full
+    (a pop reads the tail only when its copy says the ring is empty), so in steady
+    state the two threads touch the shared indices once per ring wrap-around instead
+    of once per operation, and no RMW is ever issued.
+
+    Only one thread may push and only one thread may pop at any time;
+    the tid parameter is kept for consistency with the other queues.
+*/
+template<typename T>
+class SPSCRing {
+private:
+    const size_t size;
+#ifndef DISABLE_POW2
+    const size_t mask;  //Mask to execute the modulo operation
+#endif
+    T** array;
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> tail{0};
+    uint64_t headCache = 0;     //producer's copy of head
+
+    alignas(CACHE_LINE) std::atomic<uint64_t> head{0};
+    uint64_t tailCache = 0;     //consumer's copy of tail
+
+    alignas(CACHE_LINE) std::atomic<SPSCRing*> next{nullptr};   //next ring of a LinkedSPSCQueue
+
+    SPSCRing(size_t size_param, [[maybe_unused]] const int tid, uint64_t start):
+#ifndef DISABLE_POW2
+    size{detail::nextPowTwo(size_param)},
+    mask{size - 1}
+#else
+    size{size_param}
+#endif
+    {
+        if(size == 0)
+            throw std::invalid_argument("Ring Size must be greater than 0");
+        array = new T*[size];
+        init(start);
+    }
+
+    /*
+        (Re)initializes the ring to start from the given index: used by the constructor
+        and by LinkedSPSCQueue to recycle a drained ring without reallocating it
+    */
+    void init(const uint64_t start){
+        tail.store(start,std::memory_order_relaxed);
+        head.store(start,std::memory_order_relaxed);
+        headCache = start;
+        tailCache = start;
+        next.store(nullptr,std::memory_order_relaxed);
+    }
+
+    inline T*& cell(const uint64_t index) const {
+#ifndef DISABLE_POW2
+        return array[index & mask];
+#else
+        return array[index % size];
+#endif
+    }
+
+public:
+    SPSCRing(size_t size,[[maybe_unused]] const int tid = 0): SPSCRing(size,tid,0){}
+
+    ~SPSCRing(){
+        delete[] array;
+    }
+
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    static std::string className([[maybe_unused]] bool padding = true){
+        return "BoundedSPSCQueue";
+    }
+
+    /*
+        Nonblocking push (producer only).
+        return: false if the ring is full
+    */
+    __attribute__((used,always_inline)) bool push(T* item,[[maybe_unused]] const int tid = 0){
+        if(item == nullptr)
+            throw std::invalid_argument(className(false) + " ERROR push(): item cannot be null");
+        const uint64_t tailTicket = tail.load(std::memory_order_relaxed);
+        if(tailTicket - headCache >= size){
+            headCache = head.load(std::memory_order_acquire);
+            if(tailTicket - headCache >= size)
+                return false;
+        }
+        cell(tailTicket) = item;
+        tail.store(tailTicket + 1,std::memory_order_release);
+        return true;
+    }
+
+    /*
+        Nonblocking pop (consumer only).
+        return: nullptr if the ring is empty
+    */
+    __attribute__((used,always_inline)) T* pop([[maybe_unused]] const int tid = 0){
+        const uint64_t headTicket = head.load(std::memory_order_relaxed);
+        if(headTicket == tailCache){
+            tailCache = tail.load(std::memory_order_acquire);
+            if(headTicket == tailCache)
+                return nullptr;
+        }
+        T* item = cell(headTicket);
+        head.store(headTicket + 1,std::memory_order_release);
+        return item;
+    }
+
+    inline size_t length([[maybe_unused]] const int tid = 0) const {
+        const uint64_t h = head.load(std::memory_order_acquire);
+        const uint64_t t = tail.load(std::memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+
+    template<class> friend class LinkedSPSCQueue;
+};
+
+/*
+    Unbounded single producer / single consumer queue (FastFlow uSPSC):
+    a list of SPSC rings, on the same lines as LinkedRingQueue.
+
+    When its ring is full the producer links a new one (taken from the pool if
+    available) and keeps pushing there; the consumer moves to the next ring once
+    the current one is drained and hands the old ring back to the pool.
+    With a single consumer a ring is unreachable as soon as the consumer leaves it,
+    so no memory reclamation scheme is needed.
+*/
+template<typename T>
+class LinkedSPSCQueue {
+private:
+    using Segment = SPSCRing<T>;
+
+    const size_t size;
+
+    /*
+        The counts live in the queue, on the line of the owner's ring pointer:
+        length() never reads a ring, which the consumer may have handed to the pool (and deleted)
+    */
+    alignas(CACHE_LINE) std::atomic<Segment*> tailSeg;  //producer's ring (written by the producer only)
+    std::atomic<uint64_t> pushed{0};                    //items pushed (written by the producer only)
+    alignas(CACHE_LINE) std::atomic<Segment*> headSeg;  //consumer's ring (written by the consumer only)
+    std::atomic<uint64_t> popped{0};                    //items popped (written by the consumer only)
+
+    SegmentPool<Segment> pool;  //drained rings ready to be reused
+
+    inline Segment* allocSegment(uint64_t start) {
+        Segment* seg = pool.get();
+        if(seg == nullptr)
+            seg = new Segment(size,0,start);
+        else
+            seg->init(start);
+        return seg;
+    }
+
+public:
+    LinkedSPSCQueue(size_t SegmentLength, [[maybe_unused]] size_t threads = 2):
+    size{SegmentLength}
+    {
+        Segment* sentinel = new Segment(SegmentLength);
+        tailSeg.store(sentinel,std::memory_order_relaxed);
+        headSeg.store(sentinel,std::memory_order_relaxed);
+    }
+
+    ~LinkedSPSCQueue(){
+        Segment* seg = headSeg.load();
+        while(seg != nullptr){
+            Segment* next = seg->next.load();
+            delete seg;
+            seg = next;
+        }
+    }
+
+    LinkedSPSCQueue(const LinkedSPSCQueue&) = delete;
+    LinkedSPSCQueue& operator=(const LinkedSPSCQueue&) = delete;
+
+    static std::string className([[maybe_unused]] bool padding = true){
+        return "LinkedSPSCQueue";
+    }
+
+    //producer only
+    __attribute__((used,always_inline)) void push(T* item,[[maybe_unused]] const int tid = 0){
+        if(item == nullptr)
+            throw std::invalid_argument(className(false) + " ERROR push(): item cannot be null");
+        Segment* ltail = tailSeg.load(std::memory_order_relaxed);
+        if(!ltail->push(item)){
+            Segment* seg = allocSegment(ltail->tail.load(std::memory_order_relaxed));
+            seg->push(item);
+            ltail->next.store(seg,std::memory_order_release);    //publishes the ring and the item
+            tailSeg.store(seg,std::memory_order_release);
+        }
+        pushed.store(pushed.load(std::memory_order_relaxed) + 1,std::memory_order_release);
+    }
+
+    //consumer only
+    __attribute__((used,always_inline)) T* pop([[maybe_unused]] const int tid = 0){
+        Segment* lhead = headSeg.load(std::memory_order_relaxed);
+        T* item = lhead->pop();
+        if(item == nullptr){
+            Segment* next = lhead->next.load(std::memory_order_acquire);
+            if(next == nullptr)
+                return nullptr;
+            //the producer left the ring before linking the next one: drain it first
+            item = lhead->pop();
+            if(item == nullptr){
+                headSeg.store(next,std::memory_order_release);
+                pool.put(lhead);
+                item = next->pop();
+            }
+        }
+        if(item != nullptr)
+            popped.store(popped.load(std::memory_order_relaxed) + 1,std::memory_order_release);
+        return item;
+    }
+
+    //either thread (approximate while the queue is in use)
+    inline size_t length([[maybe_unused]] const int tid = 0) const {
+        const uint64_t h = popped.load(std::memory_order_acquire);
+        const uint64_t t = pushed.load(std::memory_order_acquire);
+        return t > h ? t - h : 0;
+    }
+
+    inline uint64_t getPoolHits() const { return pool.getHits(); }
+    inline uint64_t getPoolMisses() const { return pool.getMisses(); }
+};
+
+template<typename T>
+using BoundedSPSCQueue = SPSCRing<T>;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>  // For alignas
+#include <cstdint>
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#ifndef SEGMENT_POOL_SIZE   //max number of free segments kept by every queue
+#define SEGMENT_POOL_SIZE 8
+#endif
+
+/*
+    Bounded free list of retired segments (or nodes).
+
+    Linked queues hand over the segments reclaimed by the Hazard Pointers
+    instead of deleting them, so that the next segment switch can reuse the
+    memory (re-initialized in place) without going through the allocator.
+
+    The list is an array of slots: put/get exchange a single slot so
+    no ABA problem is possible. If the pool is full the segment is deleted.
+*/
+template<class Segment, size_t Capacity = SEGMENT_POOL_SIZE>
+class SegmentPool {
+private:
+    alignas(CACHE_LINE) std::atomic<Segment*> slots[Capacity];
+    alignas(CACHE_LINE) std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+
+public:
+    SegmentPool(){
+        for(size_t i = 0; i < Capacity; i++)
+            slots[i].store(nullptr,std::memory_order_relaxed);
+    }
+
+    ~SegmentPool(){
+        for(size_t i = 0; i < Capacity; i++)
+            delete slots[i].load(std::memory_order_relaxed);
+    }
+
+    SegmentPool(const SegmentPool&) = delete;
+    SegmentPool& operator=(const SegmentPool&) = delete;
+
+    /*
+        returns a free segment (to be re-initialized by the caller)
+        or nullptr if the pool is empty
+    */
+    Segment* get(){
+        for(size_t i = 0; i < Capacity; i++){
+            if(slots[i].load(std::memory_order_relaxed) == nullptr)
+                continue;
+            Segment* seg = slots[i].exchange(nullptr,std::memory_order_acquire);
+            if(seg != nullptr){
+                hits.fetch_add(1,std::memory_order_relaxed);
+                return seg;
+            }
+        }
+        misses.fetch_add(1,std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    /*
+        stores a segment that is no more reachable by any thread,
+        deletes it if the pool is full
+    */
+    void put(Segment* seg){
+        for(size_t i = 0; i < Capacity; i++){
+            Segment* empty = nullptr;
+            if(slots[i].load(std::memory_order_relaxed) == nullptr &&
+               slots[i].compare_exchange_strong(empty,seg,std::memory_order_release,std::memory_order_relaxed))
+                return;
+        }
+        delete seg;
+    }
+
+    //number of allocations served by the pool
+    inline uint64_t getHits() const {
+        return hits.load(std::memory_order_relaxed);
+    }
+
+    //number of allocations that had to go through the allocator
+    inline uint64_t getMisses() const {
+        return misses.load(std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+#include <cstddef>  // For alignas
+#include <cstdint>
+#include <cassert>
+#include <concepts>
+
+#include "LCRQ.hpp"
+#include "LPRQ.hpp"
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#ifndef SHARDED_QUEUE_SHARDS    //default number of inner queues
+#define SHARDED_QUEUE_SHARDS 4
+#endif
+
+#ifndef SHARD_HINT_BATCH        //pushes a producer counts locally before updating the shard hint
+#define SHARD_HINT_BATCH 16
+#endif
+
+/*
+    Shard selection of ShardedQueue (Select policy):
+    - home(tid):        shard of the pushes of tid
+    - pop(tid,hint):    first shard of the pops of tid, the others are stolen in order from it;
+                        hint(shard) is the approximate length of the shard (sizeHints only)
+    - sizeHints:        ShardedQueue keeps the per shard length hints
+    - defaultShards():  number of shards if not given
+    - prefix():         prefix of the class name
+*/
+
+/*
+    A producer always pushes on its home shard (tid % K), so the items of a
+    producer stay in FIFO order. A consumer picks two random shards and pops
+    from the longer one (power of two choices).
+*/
+class RandomShard {
+private:
+    struct alignas(CACHE_LINE) Random {
+        uint64_t state;
+    };
+
+    const size_t shards;
+    std::unique_ptr<Random[]> seeds;    //per tid: random shard choices of the consumers
+
+    inline size_t randomShard(const int tid) {
+        uint64_t& x = seeds[tid].state;     //xorshift
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        return x % shards;
+    }
+
+public:
+    static constexpr bool sizeHints = true;
+
+    RandomShard(size_t shardCount, size_t threads):
+    shards{shardCount},
+    seeds{new Random[threads]}
+    {
+        for(size_t i = 0; i < threads; i++)
+            seeds[i].state = 0x9E3779B97F4A7C15ull * (i + 1);
+    }
+
+    static size_t defaultShards() { return SHARDED_QUEUE_SHARDS; }
+
+    static std::string prefix() { return "Sharded"; }
+
+    inline size_t home(const int tid) const { return tid % shards; }
+
+    template<class Hint>
+    inline size_t pop(const int tid, Hint&& hint) {
+        if(shards == 1) return 0;
+        const size_t first = randomShard(tid);
+        const size_t second = randomShard(tid);
+        return hint(first) >= hint(second) ? first : second;
+    }
+};
+
+/*
+    Relaxed FIFO multi-queue: K inner queues (shards) of type Q, any
+    multi producer / multi consumer queue of QueueTypeSet.
+
+    Select (see RandomShard) picks the shard of a push and the first shard of
+    a pop; when it is empty the consumer steals from the other shards, so a pop
+    returns nullptr only if every shard was seen empty.
+    The head / tail of a single queue are spread over K queues: the order is
+    FIFO per shard only (see RankErrorBenchmark for the relaxation).
+    The lengths seen by Select are per shard hints (relaxed load / store, updates
+    may be lost, reset when a pop finds the shard empty): the choice doesn't touch
+    the head / tail of the shards.
+    A producer counts its pushes per tid and adds them to the hint of the shard
+    every SHARD_HINT_BATCH pushes (or when it pushes on another shard), so the
+    hint line shared by the producers is written once per batch.
+
+    Bounded inner queues: a push tries the other shards when the home shard is full.
+*/
+template<typename T, template<typename> class Q, class Select = RandomShard>
+class ShardedQueue {
+private:
+    using Inner = Q<T>;
+    static constexpr bool bounded = requires(Inner* q, T* item){ { q->push(item,0) } -> std::same_as<bool>; };
+
+    struct alignas(CACHE_LINE) SizeHint {
+        std::atomic<uint64_t> items{0};
+    };
+
+    struct alignas(CACHE_LINE) PendingHint {
+        uint64_t items = 0;     //pushes not yet added to the hint of shard
+        size_t shard = 0;
+    };
+
+    const size_t shards;
+    const size_t maxThreads;
+    std::vector<std::unique_ptr<Inner>> queues;
+    Select select;
+    std::unique_ptr<SizeHint[]> hints;  //per shard: approximate length
+    std::unique_ptr<PendingHint[]> pending; //per tid: pushes counted locally (sizeHints only)
+
+    inline uint64_t hint(const size_t shard) const {
+        return hints[shard].items.load(std::memory_order_relaxed);
+    }
+
+    inline void flushHint(PendingHint& local) {
+        std::atomic<uint64_t>& items = hints[local.shard].items;
+        items.store(items.load(std::memory_order_relaxed) + local.items,std::memory_order_relaxed);
+        local.items = 0;
+    }
+
+    inline void hintPush(const size_t shard, const int tid) {
+        if constexpr (Select::sizeHints){
+            PendingHint& local = pending[tid];
+            if(local.shard != shard){
+                if(local.items != 0) flushHint(local);
+                local.shard = shard;
+            }
+            if(++local.items >= SHARD_HINT_BATCH)
+                flushHint(local);
+        }
+    }
+
+    inline T* popShard(const size_t shard, const int tid) {
+        T* item = queues[shard]->pop(tid);
+        if constexpr (Select::sizeHints){
+            std::atomic<uint64_t>& items = hints[shard].items;
+            const uint64_t n = items.load(std::memory_order_relaxed);
+            if(item == nullptr){
+                if(n != 0) items.store(0,std::memory_order_relaxed);
+            } else if(n != 0)
+                items.store(n - 1,std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+public:
+    ShardedQueue(size_t size, size_t threads = 128, size_t shardCount = Select::defaultShards()):
+    shards{shardCount},
+    maxThreads{threads},
+    select(shardCount,threads),
+    hints{new SizeHint[shardCount]},
+    pending{Select::sizeHints ? new PendingHint[threads] : nullptr}
+    {
+        if(shards == 0)
+            throw std::invalid_argument("Shards must be greater than 0");
+        for(size_t i = 0; i < shards; i++)
+            queues.push_back(std::make_unique<Inner>(size,threads));
+    }
+
+    ShardedQueue(const ShardedQueue&) = delete;
+    ShardedQueue& operator=(const ShardedQueue&) = delete;
+
+    static std::string className(bool padding = true){
+        return Select::prefix() + Inner::className(padding);
+    }
+
+    inline size_t getShards() const { return shards; }
+
+    __attribute__((used,always_inline)) auto push(T* item, const int tid) {
+        assert(tid >= 0 && static_cast<size_t>(tid) < maxThreads);
+        const size_t home = select.home(tid);
+        if constexpr (bounded){
+            for(size_t i = 0; i < shards; i++){
+                const size_t shard = (home + i) % shards;
+                if(queues[shard]->push(item,tid)){
+                    hintPush(shard,tid);
+                    return true;
+                }
+            }
+            return false;
+        } else {
+            queues[home]->push(item,tid);
+            hintPush(home,tid);
+        }
+    }
+
+    __attribute__((used,always_inline)) T* pop(const int tid) {
+        assert(tid >= 0 && static_cast<size_t>(tid) < maxThreads);
+        const size_t first = select.pop(tid,[this](size_t shard){ return hint(shard); });
+        //first choice, then steals from the other shards in order
+        for(size_t i = 0; i < shards; i++){
+            if(T* item = popShard((first + i) % shards,tid))
+                return item;
+        }
+        return nullptr;
+    }
+
+    size_t length(const int tid = 0) {
+        size_t total = 0;
+        for(auto& queue : queues)
+            total += queue->length(tid);
+        return total;
+    }
+};
+
+/*
+    Declare aliases for the sharded queues
+*/
+template<typename T>
+using ShardedLCRQueue = ShardedQueue<T,LCRQueue>;
+
+template<typename T>
+using ShardedLPRQueue = ShardedQueue<T,LPRQueue>;
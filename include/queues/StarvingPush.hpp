@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>  // For alignas
+
+#include "x86Atomics.hpp"
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#ifndef STARVATION_THRESHOLD    //failed attempts before a producer takes the slow path
+#define STARVATION_THRESHOLD 10
+#endif
+
+#ifndef SLOW_PUSH_SPIN          //checks of the request before the producer takes it back
+#define SLOW_PUSH_SPIN 1024
+#endif
+
+/*
+    Push statistics of the CRQ / PRQ segments (see StarvingPush)
+*/
+struct PushStats {
+    uint64_t slowPushes     = 0;    //producers that published their item (starving)
+    uint64_t helpedPushes   = 0;    //published items completed by a consumer
+    uint64_t forcedCloses   = 0;    //segments closed with BIT_TEST_AND_SET63
+
+    PushStats& operator+=(const PushStats& other){
+        slowPushes      += other.slowPushes;
+        helpedPushes    += other.helpedPushes;
+        forcedCloses    += other.forcedCloses;
+        return *this;
+    }
+};
+
+namespace detail{
+
+//outcome of the slow path of a starving producer (see slowPush of the CRQ / PRQ segments)
+enum class SlowPush { Helped, Closed, Retry };
+
+/*
+    Cooperative slow path of a starving producer in a CRQ / PRQ segment.
+
+    A producer fails its ticket when a consumer has overrun it (the cell is
+    invalidated) and keeps failing as long as consumers poll the empty ring.
+    After STARVATION_THRESHOLD failures it publishes its item in the request
+    slot of the segment: the next consumer that finds the ring empty takes the
+    item and returns it, completing the push on behalf of the producer
+    (the ring is empty and the push is pending, so push and pop are linearized
+    together). If nobody takes it within SLOW_PUSH_SPIN checks the producer
+    takes it back and goes on with the fast path (or closes a full ring).
+
+    One request at a time per segment: other starving producers keep retrying
+    on the fast path until the slot is free.
+    pushBatch takes the same slow path for the item it keeps failing: a helped
+    item is complete and the rest of the batch reserves a new range of tickets.
+*/
+template<typename T>
+class StarvingPush {
+private:
+    alignas(CACHE_LINE) std::atomic<T*> request{nullptr};
+    alignas(CACHE_LINE) std::atomic<uint64_t> slowPushes{0};
+    std::atomic<uint64_t> helpedPushes{0};
+    std::atomic<uint64_t> forcedCloses{0};
+
+public:
+    void reset() {
+        request.store(nullptr,std::memory_order_relaxed);
+        slowPushes.store(0,std::memory_order_relaxed);
+        helpedPushes.store(0,std::memory_order_relaxed);
+        forcedCloses.store(0,std::memory_order_relaxed);
+    }
+
+    /*
+        Slow path of the producer of item
+        return: true if a consumer took the item (the push is complete)
+    */
+    bool publish(T* item) {
+        T* empty = nullptr;
+        if(!request.compare_exchange_strong(empty,item))
+            return false;   //another producer is in the slow path
+        slowPushes.fetch_add(1,std::memory_order_relaxed);
+        for(int spin = 0; spin < SLOW_PUSH_SPIN && request.load() == item; spin++)
+            CPU_PAUSE();
+        T* expected = item;
+        if(request.compare_exchange_strong(expected,nullptr))
+            return false;   //taken back
+        helpedPushes.fetch_add(1,std::memory_order_relaxed);
+        return true;
+    }
+
+    /*
+        Called by a consumer that found the ring empty
+        return: the item of a starving producer or nullptr
+    */
+    inline T* help() {
+        T* item = request.load(std::memory_order_relaxed);
+        if(item == nullptr || !request.compare_exchange_strong(item,nullptr))
+            return nullptr;
+        return item;
+    }
+
+    inline void countForcedClose() {
+        forcedCloses.fetch_add(1,std::memory_order_relaxed);
+    }
+
+    PushStats getStats() const {
+        return PushStats{slowPushes.load(std::memory_order_relaxed),
+                         helpedPushes.load(std::memory_order_relaxed),
+                         forcedCloses.load(std::memory_order_relaxed)};
+    }
+};
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+/*
+    Thread registration for the memory reclamation policies.
+
+    Every policy keeps one record per thread slot: a slot is either fixed by the
+    caller (legacy int tid API, claimed on first use and never released) or
+    assigned by acquire() and given back by release(). Records expose an
+    std::atomic<bool> active flag: scans skip the slots nobody is using.
+*/
+
+//claims the first free slot among recordAt(0..maxThreads)
+template<class RecordAt>
+inline int claimSlot(RecordAt&& recordAt, const int maxThreads){
+    for(int iThread = 0; iThread < maxThreads; iThread++){
+        bool isFree = false;
+        auto& record = recordAt(iThread);
+        if(!record.active.load(std::memory_order_relaxed) &&
+            record.active.compare_exchange_strong(isFree,true))
+            return iThread;
+    }
+    throw std::runtime_error("No free thread slot: all the " + std::to_string(maxThreads) + " slots are registered");
+}
+
+//marks a caller-provided slot as used (legacy int tid API)
+template<class Record>
+inline void useSlot(Record& record){
+    if(!record.active.load(std::memory_order_relaxed))
+        record.active.store(true);
+}
+
+/*
+    RAII registration of a thread to a queue (returned by registerThread()).
+    Keeps the slot and a pointer to the thread's record of the reclamation policy,
+    so that the operations do not need to index the per-thread storage.
+    The slot is released when the handle goes out of scope.
+*/
+template<class Reclaimer>
+class ThreadHandle {
+private:
+    using Slot = typename Reclaimer::Slot;
+    Reclaimer* domain;
+    Slot slot;
+
+public:
+    explicit ThreadHandle(Reclaimer& reclaimer): domain{&reclaimer}, slot{reclaimer.acquire()} {}
+
+    ThreadHandle(ThreadHandle&& other) noexcept: domain{other.domain}, slot{other.slot} {
+        other.domain = nullptr;
+    }
+
+    ThreadHandle& operator=(ThreadHandle&& other) noexcept {
+        if(this != &other){
+            if(domain != nullptr) domain->release(slot);
+            domain = other.domain;
+            slot = other.slot;
+            other.domain = nullptr;
+        }
+        return *this;
+    }
+
+    ThreadHandle(const ThreadHandle&) = delete;
+    ThreadHandle& operator=(const ThreadHandle&) = delete;
+
+    ~ThreadHandle(){
+        if(domain != nullptr)
+            domain->release(slot);
+    }
+
+    inline const Slot& get() const { return slot; }
+
+    //slot assigned to the thread (usable as tid with the int API)
+    inline int tid() const { return slot.tid; }
+};
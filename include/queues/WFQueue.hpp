@@ -0,0 +1,489 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <memory>
+#include <new>
+#include <initializer_list>
+#include <stdexcept>
+#include <cstddef>  // For alignas
+#include <cstdint>
+#include <cassert>
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#ifndef WF_PATIENCE     //fast path attempts before an operation publishes its request (slow path)
+#define WF_PATIENCE 10
+#endif
+
+#ifndef WF_SPIN         //attempts on an empty cell before a dequeuer invalidates it
+#define WF_SPIN 100
+#endif
+
+/*
+    Wait-free queue (C. Yang, J. Mellor-Crummey, "A wait-free queue as fast as fetch-and-add").
+
+    An infinite array of cells, allocated in segments of SegmentLength cells, indexed by
+    two fetch_add counters (Ei for the producers, Di for the consumers).
+    Fast path: a producer takes a ticket and CASes the item into its cell, a consumer
+    takes a ticket and reads the cell (invalidating it with TOP if still empty).
+    After WF_PATIENCE failed attempts an operation switches to the slow path: it publishes
+    a request in its thread record and keeps taking cells until one is reserved for it.
+    Every thread also helps the pending request of one peer (round robin over the records),
+    so any operation completes in a bounded number of steps.
+
+    Segments are reclaimed by the dequeuer that allocates a new spare segment: the head
+    moves up to the lowest segment still referenced by a thread (segment id published in
+    the record while an operation runs, as a hazard pointer).
+
+    The records (and the helping ring) are sized by the threads given to the constructor,
+    tid must be lower than it.
+*/
+template<typename T>
+class WFQueue {
+private:
+    struct EnqReq {
+        std::atomic<int64_t> id{0};
+        std::atomic<T*>      val{nullptr};
+    };
+
+    struct DeqReq {
+        std::atomic<int64_t> id{0};
+        std::atomic<int64_t> idx{-1};
+    };
+
+    struct alignas(CACHE_LINE) Cell {
+        std::atomic<T*>      val{nullptr};
+        std::atomic<EnqReq*> enq{nullptr};
+        std::atomic<DeqReq*> deq{nullptr};
+    };
+
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        int64_t id = 0;
+
+        inline Cell* cells() {
+            return reinterpret_cast<Cell*>(reinterpret_cast<std::byte*>(this) + cellsOffset());
+        }
+
+        static constexpr size_t cellsOffset() {
+            return (sizeof(Node) + alignof(Cell) - 1) / alignof(Cell) * alignof(Cell);
+        }
+    };
+
+    static constexpr uint64_t NO_HAZARD = ~0ull;
+
+    /*
+        Thread record: the enqueue side and the dequeue side have their own hazard
+        and spare segment, so one producer and one consumer can share a tid
+    */
+    struct alignas(CACHE_LINE) Record {
+        std::atomic<uint64_t> enqHzd{NO_HAZARD};        //segment in use by the current enqueue
+        std::atomic<uint64_t> deqHzd{NO_HAZARD};        //segment in use by the current dequeue
+        std::atomic<Node*>    Ep;                       //segment of the last enqueue
+        std::atomic<Node*>    Dp;                       //segment of the last dequeue
+        Record* next = nullptr;                         //helping ring
+        alignas(CACHE_LINE) EnqReq Er;
+        uint64_t enqNodeId = 0;
+        Node* enqSpare = nullptr;                       //preallocated segment
+        alignas(CACHE_LINE) DeqReq Dr;
+        uint64_t deqNodeId = 0;
+        Node* deqSpare = nullptr;
+        Record* Eh = nullptr;                           //enqueue peer to help
+        int64_t Ei = 0;                                 //request id of the enqueue peer
+        Record* Dh = nullptr;                           //dequeue peer to help
+    };
+
+    const size_t size;          //cells per segment
+    const size_t maxThreads;
+
+    alignas(CACHE_LINE) std::atomic<int64_t> Ei{1};     //enqueue index
+    alignas(CACHE_LINE) std::atomic<int64_t> Di{1};     //dequeue index
+    alignas(CACHE_LINE) std::atomic<int64_t> Hi{0};     //id of the first segment, -1 while a cleanup runs
+    Node* Hp;                                           //first segment
+
+    std::unique_ptr<Record[]> records;
+    std::unique_ptr<Record*[]> cleanupScratch;          //records visited by a cleanup (one cleanup at a time)
+
+    static inline T* top() { return reinterpret_cast<T*>(~uintptr_t{0}); }
+    static inline EnqReq* enqTop() { return reinterpret_cast<EnqReq*>(~uintptr_t{0}); }
+    static inline DeqReq* deqTop() { return reinterpret_cast<DeqReq*>(~uintptr_t{0}); }
+
+    Node* allocNode(int64_t id) {
+        void* mem = ::operator new(Node::cellsOffset() + size * sizeof(Cell), std::align_val_t{CACHE_LINE});
+        Node* node = new (mem) Node();
+        node->id = id;
+        Cell* cells = node->cells();
+        for(size_t i = 0; i < size; i++)
+            new (&cells[i]) Cell();
+        return node;
+    }
+
+    static void freeNode(Node* node) {
+        node->~Node();
+        ::operator delete(node, std::align_val_t{CACHE_LINE});
+    }
+
+    //cell of index i, walking (and extending) the segment list from *ptr
+    Cell* findCell(Node*& ptr, const int64_t i, Node*& spare) {
+        Node* curr = ptr;
+        for(int64_t j = curr->id; j < i / static_cast<int64_t>(size); ++j){
+            Node* next = curr->next.load(std::memory_order_acquire);
+            if(next == nullptr){
+                Node* temp = spare;
+                if(temp == nullptr){
+                    temp = allocNode(0);
+                    spare = temp;
+                }
+                temp->id = j + 1;
+                if(curr->next.compare_exchange_strong(next,temp,std::memory_order_release,std::memory_order_acquire)){
+                    next = temp;
+                    spare = nullptr;
+                }
+            }
+            curr = next;
+        }
+        ptr = curr;
+        return &curr->cells()[i % size];
+    }
+
+    inline Cell* findCell(std::atomic<Node*>& ptr, const int64_t i, Node*& spare) {
+        Node* p = ptr.load(std::memory_order_acquire);
+        Cell* c = findCell(p,i,spare);
+        ptr.store(p,std::memory_order_release);
+        return c;
+    }
+
+    bool enqFast(T* v, Record& th, int64_t& id) {
+        const int64_t i = Ei.fetch_add(1);
+        Cell* c = findCell(th.Ep,i,th.enqSpare);
+        T* cv = nullptr;
+        if(c->val.compare_exchange_strong(cv,v))
+            return true;
+        id = i;
+        return false;
+    }
+
+    void enqSlow(T* v, Record& th, int64_t id) {
+        EnqReq* enq = &th.Er;
+        enq->val.store(v,std::memory_order_relaxed);
+        enq->id.store(id,std::memory_order_release);
+
+        Node* tail = th.Ep.load(std::memory_order_acquire);
+        int64_t i;
+        do {
+            i = Ei.fetch_add(1);
+            Cell* c = findCell(tail,i,th.enqSpare);
+            EnqReq* ce = nullptr;
+            if(c->enq.compare_exchange_strong(ce,enq) && c->val.load() != top()){
+                enq->id.compare_exchange_strong(id,-i);
+                break;
+            }
+        } while(enq->id.load() > 0);
+
+        id = -enq->id.load();
+        Cell* c = findCell(th.Ep,id,th.enqSpare);
+        if(id > i){
+            int64_t ei = Ei.load();
+            while(ei <= id && !Ei.compare_exchange_weak(ei,id + 1));
+        }
+        c->val.store(v);
+    }
+
+    //completes (or invalidates) the enqueue of cell i, returns its value (nullptr: empty, top(): retry)
+    T* helpEnq(Record& th, Cell* c, const int64_t i) {
+        T* v = nullptr;
+        for(int iSpin = 0; iSpin < WF_SPIN && (v = c->val.load()) == nullptr; iSpin++);
+
+        if((v != top() && v != nullptr) ||
+           (v == nullptr && !c->val.compare_exchange_strong(v,top()) && v != top()))
+            return v;
+
+        EnqReq* e = c->enq.load();
+        if(e == nullptr){
+            Record* ph = th.Eh;
+            EnqReq* pe = &ph->Er;
+            int64_t id = pe->id.load();
+            if(th.Ei != 0 && th.Ei != id){
+                th.Ei = 0;
+                th.Eh = ph->next;
+                ph = th.Eh;
+                pe = &ph->Er;
+                id = pe->id.load();
+            }
+            if(id > 0 && id <= i && !c->enq.compare_exchange_strong(e,pe) && e != pe)
+                th.Ei = id;     //the peer is still pending: help it again next time
+            else {
+                th.Ei = 0;
+                th.Eh = ph->next;
+            }
+
+            if(e == nullptr && c->enq.compare_exchange_strong(e,enqTop()))
+                e = enqTop();
+        }
+
+        if(e == enqTop())
+            return Ei.load() <= i ? nullptr : top();
+
+        int64_t ei = e->id.load(std::memory_order_acquire);
+        T* ev = e->val.load(std::memory_order_acquire);
+        if(ei > i){
+            if(c->val.load() == top() && Ei.load() <= i)
+                return nullptr;
+        } else {
+            if((ei > 0 && e->id.compare_exchange_strong(ei,-i)) || (ei == -i && c->val.load() == top())){
+                int64_t eidx = Ei.load();
+                while(eidx <= i && !Ei.compare_exchange_weak(eidx,i + 1));
+                c->val.store(ev);
+            }
+        }
+        return c->val.load();
+    }
+
+    void helpDeq(Record& th, Record& ph) {
+        DeqReq* deq = &ph.Dr;
+        int64_t idx = deq->idx.load(std::memory_order_acquire);
+        const int64_t id = deq->id.load();
+        if(idx < id)
+            return;
+
+        Node* Dp = ph.Dp.load(std::memory_order_acquire);
+        th.deqHzd.store(ph.deqHzd.load());  //seq_cst: published before reading the segments
+        idx = deq->idx.load();
+
+        int64_t i = id + 1, old = id, found = 0;
+        while(true){
+            Node* h = Dp;
+            for(; idx == old && found == 0; ++i){
+                Cell* c = findCell(h,i,th.deqSpare);
+                int64_t di = Di.load();
+                while(di <= i && !Di.compare_exchange_weak(di,i + 1));
+
+                T* v = helpEnq(th,c,i);
+                if(v == nullptr || (v != top() && c->deq.load() == nullptr))
+                    found = i;
+                else
+                    idx = deq->idx.load(std::memory_order_acquire);
+            }
+
+            if(found != 0){
+                if(deq->idx.compare_exchange_strong(idx,found))
+                    idx = found;
+                if(idx >= found)
+                    found = 0;
+            }
+
+            if(idx < 0 || deq->id.load() != id)
+                break;
+
+            Cell* c = findCell(Dp,idx,th.deqSpare);
+            DeqReq* cd = nullptr;
+            if(c->val.load() == top() || c->deq.compare_exchange_strong(cd,deq) || cd == deq){
+                deq->idx.compare_exchange_strong(idx,-idx);
+                break;
+            }
+
+            old = idx;
+            if(idx >= i)
+                i = idx + 1;
+        }
+    }
+
+    //return: the item, nullptr if empty, top() to retry
+    T* deqFast(Record& th, int64_t& id) {
+        const int64_t i = Di.fetch_add(1);
+        Cell* c = findCell(th.Dp,i,th.deqSpare);
+        T* v = helpEnq(th,c,i);
+        DeqReq* cd = nullptr;
+        if(v == nullptr)
+            return nullptr;
+        if(v != top() && c->deq.compare_exchange_strong(cd,deqTop()))
+            return v;
+        id = i;
+        return top();
+    }
+
+    T* deqSlow(Record& th, const int64_t id) {
+        DeqReq* deq = &th.Dr;
+        deq->id.store(id,std::memory_order_release);
+        deq->idx.store(id,std::memory_order_release);
+
+        helpDeq(th,th);
+        const int64_t i = -deq->idx.load();
+        Cell* c = findCell(th.Dp,i,th.deqSpare);
+        T* val = c->val.load();
+        return val == top() ? nullptr : val;
+    }
+
+    //lowest segment among cur and the ones announced by a record
+    static Node* check(const Record& ph, Node* cur, Node* old) {
+        for(const std::atomic<uint64_t>* hzdNodeId : {&ph.enqHzd,&ph.deqHzd}){
+            const uint64_t hzd = hzdNodeId->load(std::memory_order_acquire);
+            if(hzd < static_cast<uint64_t>(cur->id)){
+                Node* tmp = old;
+                while(static_cast<uint64_t>(tmp->id) < hzd)
+                    tmp = tmp->next.load();
+                cur = tmp;
+            }
+        }
+        return cur;
+    }
+
+    //moves a record's segment pointer up to cur (or lowers cur to it)
+    static Node* update(std::atomic<Node*>& pn, Node* cur, const Record& ph, Node* old) {
+        Node* ptr = pn.load(std::memory_order_acquire);
+        if(ptr->id < cur->id){
+            if(!pn.compare_exchange_strong(ptr,cur)){
+                if(ptr->id < cur->id)
+                    cur = ptr;
+            }
+            cur = check(ph,cur,old);
+        }
+        return cur;
+    }
+
+    //frees the segments below the lowest one still in use by a thread
+    void cleanup(Record& th) {
+        int64_t oid = Hi.load(std::memory_order_acquire);
+        Node* cur = th.Dp.load();
+        if(oid == -1)
+            return;
+        if(cur->id - oid < static_cast<int64_t>(2 * maxThreads))
+            return;
+        if(!Hi.compare_exchange_strong(oid,-1,std::memory_order_acquire))
+            return;
+
+        //enqueuers lagging behind the dequeuers must not look for cells in freed segments
+        const int64_t di = Di.load();
+        int64_t ei = Ei.load();
+        while(ei <= di && !Ei.compare_exchange_weak(ei,di + 1));
+
+        Node* old = Hp;
+        Record* ph = &th;
+        int i = 0;
+        do {
+            cur = check(*ph,cur,old);
+            cur = update(ph->Ep,cur,*ph,old);
+            cur = update(ph->Dp,cur,*ph,old);
+            cleanupScratch[i++] = ph;
+            ph = ph->next;
+        } while(cur->id > oid && ph != &th);
+
+        while(cur->id > oid && --i >= 0)
+            cur = check(*cleanupScratch[i],cur,old);
+
+        const int64_t nid = cur->id;
+        if(nid <= oid){
+            Hi.store(oid,std::memory_order_release);
+        } else {
+            Hp = cur;
+            Hi.store(nid,std::memory_order_release);
+            while(old != cur){
+                Node* tmp = old->next.load();
+                freeNode(old);
+                old = tmp;
+            }
+        }
+    }
+
+public:
+    WFQueue(size_t SegmentLength, size_t threads = 128):
+    size{SegmentLength},
+    maxThreads{threads},
+    records{new Record[threads]},
+    cleanupScratch{new Record*[threads]}
+    {
+        if(size == 0)
+            throw std::invalid_argument("Segment Length must be greater than 0");
+        assert(threads > 0);
+        Hp = allocNode(0);
+        for(size_t i = 0; i < maxThreads; i++){
+            Record& th = records[i];
+            th.Ep.store(Hp,std::memory_order_relaxed);
+            th.Dp.store(Hp,std::memory_order_relaxed);
+            th.next = &records[(i + 1) % maxThreads];
+            th.Eh = th.next;
+            th.Dh = th.next;
+        }
+    }
+
+    ~WFQueue(){
+        Node* node = Hp;
+        while(node != nullptr){
+            Node* next = node->next.load();
+            freeNode(node);
+            node = next;
+        }
+        for(size_t i = 0; i < maxThreads; i++){
+            if(records[i].enqSpare != nullptr)
+                freeNode(records[i].enqSpare);
+            if(records[i].deqSpare != nullptr)
+                freeNode(records[i].deqSpare);
+        }
+    }
+
+    WFQueue(const WFQueue&) = delete;
+    WFQueue& operator=(const WFQueue&) = delete;
+
+    static std::string className([[maybe_unused]] bool padding = true){
+        return "WFQueue";
+    }
+
+    __attribute__((used,always_inline)) void push(T* item, const int tid){
+        if(item == nullptr || item == top())
+            throw std::invalid_argument(className(false) + " ERROR push(): invalid item");
+        assert(tid >= 0 && static_cast<size_t>(tid) < maxThreads);
+        Record& th = records[tid];
+        th.enqHzd.store(th.enqNodeId);
+
+        int64_t id = 0;
+        int p = WF_PATIENCE;
+        while(!enqFast(item,th,id) && p-- > 0);
+        if(p < 0)
+            enqSlow(item,th,id);
+
+        th.enqNodeId = th.Ep.load(std::memory_order_relaxed)->id;
+        th.enqHzd.store(NO_HAZARD,std::memory_order_release);
+    }
+
+    __attribute__((used,always_inline)) T* pop(const int tid){
+        assert(tid >= 0 && static_cast<size_t>(tid) < maxThreads);
+        Record& th = records[tid];
+        th.deqHzd.store(th.deqNodeId);
+
+        T* v;
+        int64_t id = 0;
+        int p = WF_PATIENCE;
+        do
+            v = deqFast(th,id);
+        while(v == top() && p-- > 0);
+        if(v == top())
+            v = deqSlow(th,id);
+
+        if(v != nullptr){
+            helpDeq(th,*th.Dh);
+            th.Dh = th.Dh->next;
+        }
+
+        th.deqNodeId = th.Dp.load(std::memory_order_relaxed)->id;
+        th.deqHzd.store(NO_HAZARD,std::memory_order_release);
+
+        if(th.deqSpare == nullptr){
+            cleanup(th);
+            th.deqSpare = allocNode(0);
+        }
+        return v;
+    }
+
+    /*
+        Upper bound: slow path enqueues may leave behind tickets no item will use,
+        it is exact while the operations take the fast path
+    */
+    size_t length([[maybe_unused]] const int tid = 0) const {
+        const int64_t e = Ei.load();
+        const int64_t d = Di.load();
+        return e > d ? e - d : 0;
+    }
+};
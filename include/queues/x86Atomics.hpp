@@ -21,3 +21,6 @@
     char __ret;                                                 \
     asm volatile("lock btsq $63, %0; setnc %1" : "+m"(*ptr), "=a"(__ret) : : "cc"); \
     __ret; })
+
+//spin-wait hint
+#define CPU_PAUSE() __builtin_ia32_pause()
@@ -4,6 +4,8 @@
         #if __has_include(<numa.h>)
             #include <numa.h>
             #include <pthread.h>
+            #include <sched.h>
+            #include <vector>
         #else
             #define DISABLE_NUMA
             #warning "numa_ctrl not found, NUMA support will be disabled"
@@ -15,11 +17,25 @@
 #ifndef DISABLE_NUMA
 
 inline bool isNumaAvailable() {
-    return numa_available() == 0;
+    static const bool available = numa_available() == 0;   //numa_available is a syscall
+    return available;
 }
 
+//numa_node_of_cpu scans the cpumask of every node: the mapping is read once
 inline int getNumaNode() {
-    return numa_node_of_cpu(sched_getcpu());
+    static const std::vector<int> cpuNode = []{
+        std::vector<int> nodes(numa_num_configured_cpus());
+        for(size_t cpu = 0; cpu < nodes.size(); cpu++)
+            nodes[cpu] = numa_node_of_cpu(cpu);
+        return nodes;
+    }();
+    const int cpu = sched_getcpu();
+    return (cpu >= 0 && static_cast<size_t>(cpu) < cpuNode.size()) ? cpuNode[cpu] : numa_node_of_cpu(cpu);
+}
+
+//number of configured nodes (1 if NUMA is not available)
+inline int getNumaNodes() {
+    return isNumaAvailable() ? numa_num_configured_nodes() : 1;
 }
 
 #else
@@ -32,6 +48,10 @@ inline int getNumaNode() {
     return 0;
 }
 
+inline int getNumaNodes() {
+    return 1;
+}
+
 #endif  //DISABLE_NUMA
 
 
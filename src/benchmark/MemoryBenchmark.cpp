@@ -77,6 +77,15 @@ void MemoryBenchmark::MemoryControl::consumers(std::chrono::milliseconds init,
         level |= CONS;
     }
 
+void MemoryBenchmark::MemoryControl::stall(size_t consumers,
+                                           std::chrono::milliseconds stallTime,
+                                           std::chrono::milliseconds period)
+    {
+        stalledConsumers = consumers;
+        this->stallTime = stallTime;
+        stallPeriod = period;
+    }
+
 /**
  * MEMORY BENCHMARK CLASS
  */
@@ -103,6 +112,7 @@ MemoryBenchmark::MemoryBenchmark(size_t prodCount, size_t consCount, double addi
             producerAdditionalWork = additionalWork;
             consumerAdditionalWork = additionalWork;
         }
+        setClusterMode(flags._cluster);
     }
 
 void MemoryBenchmark::printHeader(std::string filePath){
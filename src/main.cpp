@@ -10,10 +10,23 @@
 #include <chrono>
 #include "PairsBenchmark.hpp"
 #include "MemoryBenchmark.hpp"
+#include <string_view>
+
+//cluster mode from the key:val arguments of benchmarks.py (cluster:Off|Cohort), the other keys are ignored
+static ClusterMode clusterArgument(int argc, char** argv){
+    constexpr std::string_view key = "cluster:";
+    ClusterMode mode = ClusterMode::Off;
+    for(int i = 1; i < argc; i++){
+        const std::string_view arg = argv[i];
+        if(arg.starts_with(key))
+            mode = parseClusterMode(arg.substr(key.size()));
+    }
+    return mode;
+}
 
-int main(void){
+int main(int argc, char** argv){
     //LMTQueue<int> queue(128, 128);
-    bench::Benchmark::Arguments args(true,true,false);
+    bench::Benchmark::Arguments args(true,true,false,clusterArgument(argc,argv));  //ClusterMode::Cohort: per node batching of the segments
     // bench::PairsBenchmark bench(1,1,0.0,false,1024,1000000,args);
     // bench.ProducerConsumer<LCRQueue>(std::chrono::seconds{5}, 10);
     // bench::SymmetricBenchmark bench(6,0.0,1024*8,100000,args);
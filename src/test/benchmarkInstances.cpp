@@ -0,0 +1,39 @@
+/**
+ * Compile-only translation unit: instantiates the benchmark series that
+ * src/main.cpp does not run, so that every build type checks their bodies
+ * (with one queue at least of every set of QueueTypeSet.hpp). Nothing here is executed.
+ */
+#include "QueueTypeSet.hpp"
+#include "ProdConsBenchmark.hpp"
+#include "ManyQueuesBenchmark.hpp"
+#include "SymmetricBenchmark.hpp"
+#include "LatencyBenchmark.hpp"
+#include "RankErrorBenchmark.hpp"
+
+using namespace bench;
+
+using InstantiatedQueues = TemplateSet< LCRQueue,WFQueue,BoundedCRQueue,LinkedSPSCQueue,BoundedSPSCQueue,
+                                        MPSCQueue,LMPSCQueue,ShardedLCRQueue,NumaLCRQueue,LMTQueueJitter,
+                                        LCRQueueEBR,FAAQueueIBR,LCRQueueRemap,LCRQueueFixed>;
+
+//taking the address of a series instantiates its body
+[[maybe_unused]] static void instantiate(){
+    InstantiatedQueues::foreach([]<template<typename> typename Q>(){
+        (void)&ProdConsBenchmark::runBatchSeries<Q>;
+        (void)&ProdConsBenchmark::runBlockingSeries<Q>;
+        (void)&ProdConsBenchmark::runMPSCSeries<Q>;
+        (void)&SymmetricBenchmark::runFootprintSeries<Q>;
+        (void)&LatencyBenchmark::runSeries<Q>;
+        (void)&ProdConsBenchmark::runPayloadSeries<Q>;
+    });
+    //queues sharing a reclamation domain (makeDomain)
+    TemplateSet<LCRQueue,FAAQueue,LSCQueue>::foreach([]<template<typename> typename Q>(){
+        (void)&ManyQueuesBenchmark::runSeries<Q>;
+    });
+    RelaxedQueues::foreach([]<template<typename> typename Q>(){
+        (void)&RankErrorBenchmark::runSeries<Q>;
+    });
+    InlineQueues::foreach([]<template<typename> typename Q>(){
+        (void)&ProdConsBenchmark::runPayloadSeries<Q>;
+    });
+}
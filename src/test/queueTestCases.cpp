@@ -9,9 +9,18 @@
 
 #include "FAArray.hpp"
 #include "LCRQ.hpp"
+#include "CompactCRQ.hpp"
 #include "LPRQ.hpp"
+#include "LSCQ.hpp"
 #include "MuxQueue.hpp"
 #include "LMTQ.hpp"
+#include "SPSCQueue.hpp"
+#include "MPSCQueue.hpp"
+#include "LMPSCQ.hpp"
+#include "WFQueue.hpp"
+#include "ShardedQueue.hpp"
+#include "NumaQueue.hpp"
+#include "InlineQueue.hpp"
 #include "ThreadGroup.hpp"
 
 #define CONCURRENT_RUN 2
@@ -19,11 +28,43 @@
 
 // Define type aliases for each queue type you want to test
 template<typename V>
-using UnboundedQueues = ::testing::Types<FAAQueue<V>,LCRQueue<V>, LPRQueue<V>, LinkedMuxQueue<V>,LMTQueue<V>>; //LMTQ works
+using UnboundedQueues = ::testing::Types<FAAQueue<V>,LCRQueue<V>, LPRQueue<V>, LinkedMuxQueue<V>,LMTQueue<V>, //LMTQ works
+                                        FAAQueueEBR<V>,LCRQueueEBR<V>,LPRQueueNoReclaim<V>,
+                                        LCRQueueIBR<V>,FAAQueueIBR<V>,LSCQueue<V>,LSCQueueIBR<V>,WFQueue<V>,
+                                        ShardedLCRQueue<V>,NumaLCRQueue<V>,LMTQueueNoBackoff<V>,LMTQueueJitter<V>,LMTQueueYield<V>,
+                                        LCRQueueRemap<V>,LPRQueueRemap<V>,LMTQueueRemap<V>,FAAQueueRemap<V>,LCompactCRQueue<V>>;
 //using UnboundedQueues = ::testing::Types<LMTQueue<V>>;
 template<typename V>
-using BoundedQueues = ::testing::Types<BoundedMTQueue<V>,BoundedPRQueue<V>,BoundedMuxQueue<V>,BoundedCRQueue<V>>;
+using BoundedQueues = ::testing::Types<BoundedMTQueue<V>,BoundedPRQueue<V>,BoundedMuxQueue<V>,BoundedCRQueue<V>,
+                                      BoundedMTQueueNoBackoff<V>,BoundedMTQueueJitter<V>,BoundedMTQueueYield<V>,
+                                      BoundedCRQueueRemap<V>,BoundedPRQueueRemap<V>,BoundedMTQueueRemap<V>,BoundedCompactCRQueue<V>>;
 //using BoundedQueues = ::testing::Types<BoundedMTQueue<V>>;
+template<typename V>
+using BatchQueues = ::testing::Types<LCRQueue<V>,LPRQueue<V>>;
+
+template<typename V>
+using PooledQueues = ::testing::Types<FAAQueue<V>,LCRQueue<V>,LPRQueue<V>,LMTQueue<V>,FAAQueueEBR<V>,LCRQueueEBR<V>,
+                                     LCRQueueIBR<V>,FAAQueueIBR<V>,LMPSCQueue<V>,LSCQueue<V>>;
+
+template<typename V>
+using BoundedMemoryQueues = ::testing::Types<LCRQueue<V>,LCRQueueIBR<V>,LPRQueueIBR<V>,FAAQueueIBR<V>>;
+
+template<typename V>
+using SharedDomainQueues = ::testing::Types<FAAQueue<V>,LCRQueue<V>,LPRQueue<V>,LCRQueueEBR<V>,LCRQueueIBR<V>,FAAQueueIBR<V>>;
+
+template<typename V>
+using BlockingQueues = ::testing::Types<FAAQueue<V>,LCRQueue<V>,LPRQueue<V>,LMTQueue<V>,LCRQueueIBR<V>,
+                                       BoundedCRQueue<V>,BoundedPRQueue<V>>;
+
+template<typename V>
+using SPSCQueues = ::testing::Types<LinkedSPSCQueue<V>,BoundedSPSCQueue<V>>;
+
+template<typename V>
+using MPSCQueues = ::testing::Types<MPSCQueue<V>,LMPSCQueue<V>>;
+
+template<typename V>
+using RegisteringQueues = ::testing::Types<FAAQueue<V>,LCRQueue<V>,LPRQueue<V>,LMTQueue<V>,
+                                          LCRQueueEBR<V>,LCRQueueIBR<V>,FAAQueueIBR<V>,LPRQueueNoReclaim<V>>;
 
 // Test setup for unbounded queues
 template <typename Q>
@@ -120,7 +161,7 @@ TYPED_TEST(Bounded_Traits, OverflowRing) {
 
     int try_overwrite = 0;
 
-    for(int i = 0; i< this->RingSize; i++){
+    for(size_t i = 0; i< this->RingSize; i++){
         //init values and ship them
         EXPECT_EQ(queue.push(&(values[i]), 0),true);
     }
@@ -128,7 +169,7 @@ TYPED_TEST(Bounded_Traits, OverflowRing) {
     for(int i = 0; i< 100; i++)
         EXPECT_EQ(queue.push(&try_overwrite,0),false);
     
-    for(int i = 0; i< this->RingSize; i++)
+    for(size_t i = 0; i< this->RingSize; i++)
         EXPECT_EQ(*queue.pop(0),values[i]);
     
 
@@ -147,7 +188,7 @@ TYPED_TEST(Bounded_Traits, FlowRing){
     std::uniform_int_distribution<> dis(this->RingSize + 1,(this->RingSize * 10) + 1);
     
     for(int j = 0; j< 100; j++){
-        for(int i = 0; i<this->RingSize; i++){
+        for(size_t i = 0; i<this->RingSize; i++){
             values[i] = i+1;
             EXPECT_EQ(queue.push(&(values[i]),0),true);
         }
@@ -161,7 +202,7 @@ TYPED_TEST(Bounded_Traits, FlowRing){
         for(int i = 0; i< n_enqueue; i++)
             EXPECT_EQ(queue.push(&(try_overwrite),0),false);
 
-        for(int i = 0; i< this->RingSize; i++)
+        for(size_t i = 0; i< this->RingSize; i++)
             EXPECT_EQ(*queue.pop(0),values[i]);
         
         for(int i = 0; i< dis(gen); i++)
@@ -182,7 +223,7 @@ TYPED_TEST(Bounded_Traits, EnqueueDequeueStress){
     int try_overwrite = 0;
 
     for(int i = 0; i< 10; ++i) {
-        for(int j = 0; j < this->RingSize; ++j) {
+        for(size_t j = 0; j < this->RingSize; ++j) {
             EXPECT_EQ(queue.push(&(values[j%size]), 0),true);
             EXPECT_EQ(j+1,queue.length()) << "Failed at insertion " << j << " of run " << i;
         }
@@ -192,7 +233,7 @@ TYPED_TEST(Bounded_Traits, EnqueueDequeueStress){
             EXPECT_EQ(queue.length(),this->RingSize);    //full queue;
         }
 
-        for(int j = 0; j < this->RingSize; ++j){
+        for(size_t j = 0; j < this->RingSize; ++j){
             EXPECT_EQ((queue.pop(0)),&(values[j%size])) << "Failed at extraction " << j << " of run " << i;
             //EXPECT_EQ(this->RingSize - j - 1,queue.size()) << "Failed at iteration " << j << " of run " << i;
         }
@@ -240,7 +281,7 @@ TYPED_TEST(Unbounded_Concurrent,TransferAllItems){
     const size_t numRuns = CONCURRENT_RUN;
     const size_t iter = 10'000;
 
-    for(int iThread = 1 ; iThread < numRuns; iThread++){
+    for(int iThread = 1 ; iThread < static_cast<int>(numRuns); iThread++){
         std::vector<uint64_t> sum(iThread);
         std::barrier<> prodBarrier(iThread + 1);
         ThreadGroup prod, cons;
@@ -354,7 +395,9 @@ TYPED_TEST(Unbounded_Concurrent,QueueSemantics){
             for(size_t i = 1; i < consData.size(); i++){
                 const UserData& deq1 = consData[i-1];
                 const UserData& deq2 = consData[i];
-                if(deq1.tid == deq2.tid) EXPECT_LT(deq1.id,deq2.id) << "Failed at run " << iThread;  
+                if(deq1.tid == deq2.tid){
+                    EXPECT_LT(deq1.id,deq2.id) << "Failed at run " << iThread;
+                }
             }
         }
 
@@ -396,7 +439,7 @@ TYPED_TEST(Bounded_Concurrent,TransferAllItems){
     const uint64_t numRuns = CONCURRENT_RUN;
     const uint64_t iter = 20'000;
 
-    for(int iThread = 1 ; iThread < numRuns; iThread++){
+    for(int iThread = 1 ; iThread < static_cast<int>(numRuns); iThread++){
         std::vector<uint64_t> sum(iThread);
         std::barrier<> prodBarrier(iThread + 1);
         ThreadGroup prod, cons;
@@ -503,7 +546,9 @@ TYPED_TEST(Bounded_Concurrent,QueueSemantics){
             for(size_t i = 1; i < consData.size(); i++){
                 const UserData& deq1 = consData[i-1]; 
                 const UserData& deq2 = consData[i];
-                if(deq1.tid == deq2.tid) EXPECT_LT(deq1.id,deq2.id) << "Failed at run " << iThread;  
+                if(deq1.tid == deq2.tid){
+                    EXPECT_LT(deq1.id,deq2.id) << "Failed at run " << iThread;
+                }
             }
         }
 
@@ -523,6 +568,1266 @@ TYPED_TEST(Bounded_Concurrent,QueueSemantics){
 
 
 
+// Test setup for queues with the pushBatch/popBatch API
+template <typename Q>
+class Batch_Traits : public ::testing::Test {
+public:
+    static constexpr size_t RING_SIZE = 20;
+    static constexpr int THREADS = 128;
+    Q queue;
+
+    Batch_Traits() : queue(RING_SIZE,THREADS){}
+};
+
+using BatchQueuesOfUserData = BatchQueues<UserData>;
+
+TYPED_TEST_SUITE(Batch_Traits, BatchQueuesOfUserData);
+
+/**
+ * Batches larger than a segment must be carried over the following
+ * segments without losing the FIFO order
+ */
+TYPED_TEST(Batch_Traits, OverflowRing){
+    TypeParam& queue = this->queue;
+    const size_t items = 200;
+    std::vector<UserData> values(items);
+    std::vector<UserData*> in(items), out(items);
+    for(size_t i = 0; i < items; i++){
+        values[i] = {0,i};
+        in[i] = &values[i];
+    }
+
+    for(size_t batch : {1ul, 7ul, 20ul, 64ul}){
+        for(size_t i = 0; i < items; i += batch)
+            queue.pushBatch(in.data() + i, std::min(batch, items - i), 0);
+        EXPECT_GE(queue.length(0), items);  //closed segments may count a few wasted tickets
+
+        size_t popped = 0;
+        while(popped < items){
+            size_t got = queue.popBatch(out.data() + popped, std::min(batch, items - popped), 0);
+            ASSERT_NE(got, 0) << "Failed at batch " << batch << " after " << popped << " items";
+            popped += got;
+        }
+        for(size_t i = 0; i < items; i++)
+            EXPECT_EQ(out[i], in[i]) << "Failed at item " << i << " with batch " << batch;
+
+        EXPECT_EQ(queue.popBatch(out.data(), batch, 0), 0);
+        EXPECT_EQ(queue.pop(0), nullptr);
+    }
+}
+
+TYPED_TEST(Batch_Traits, MixedOperations){
+    TypeParam& queue = this->queue;
+    const size_t items = 50;
+    std::vector<UserData> values(items);
+    std::vector<UserData*> in(items), out(items);
+    for(size_t i = 0; i < items; i++){
+        values[i] = {0,i};
+        in[i] = &values[i];
+    }
+
+    //batched producer, single consumer
+    queue.pushBatch(in.data(), items, 0);
+    for(size_t i = 0; i < items; i++)
+        EXPECT_EQ(queue.pop(0), in[i]);
+    EXPECT_EQ(queue.pop(0), nullptr);
+
+    //single producer, batched consumer (asks for more than available)
+    for(size_t i = 0; i < items; i++)
+        queue.push(in[i], 0);
+    EXPECT_EQ(queue.popBatch(out.data(), items + 10, 0), items);
+    for(size_t i = 0; i < items; i++)
+        EXPECT_EQ(out[i], in[i]);
+    EXPECT_EQ(queue.length(0), 0);
+}
+
+TYPED_TEST(Batch_Traits, TransferAllItems){
+    TypeParam& queue = this->queue;
+    const size_t producers = 2, consumers = 2;
+    const size_t iter = 10'000, batch = 16;
+    std::vector<std::vector<UserData>> producersData(producers);
+    std::vector<uint64_t> sum(consumers);
+    std::atomic<bool> stopFlag{false};
+    ThreadGroup prod, cons;
+
+    for(size_t i = 0; i < producers; i++)
+        for(size_t j = 1; j <= iter; j++)
+            producersData[i].push_back(UserData{static_cast<int>(i),j});
+
+    const auto producer = [&queue,&producersData,iter,batch](const int tid){
+        std::vector<UserData*> items;
+        for(auto& elem : producersData[tid])
+            items.push_back(&elem);
+        for(size_t i = 0; i < iter; i += batch)
+            queue.pushBatch(items.data() + i, std::min(batch, iter - i), tid);
+    };
+
+    const auto consumer = [&queue,&stopFlag,batch](const int tid){
+        uint64_t sum = 0;
+        std::vector<UserData*> out(batch);
+        size_t got;
+        while(!stopFlag.load()){
+            got = queue.popBatch(out.data(), batch, tid);
+            for(size_t i = 0; i < got; i++) sum += out[i]->id;
+        }
+        do{
+            got = queue.popBatch(out.data(), batch, tid);
+            for(size_t i = 0; i < got; i++) sum += out[i]->id;
+        }while(got != 0);
+        return sum;
+    };
+
+    for(size_t i = 0; i < producers; i++)
+        prod.thread(producer);
+    for(size_t i = 0; i < consumers; i++)
+        cons.threadWithResult(consumer,sum[i]);
+    prod.join();
+    stopFlag.store(true);
+    cons.join();
+
+    uint64_t total = std::accumulate(sum.begin(),sum.end(),0ull);
+    EXPECT_EQ(total, producers * iter * (iter + 1) / 2);
+    EXPECT_EQ(queue.pop(0), nullptr);
+}
+
+// Test setup for linked queues recycling their segments through a SegmentPool
+template <typename Q>
+class Pool_Traits : public ::testing::Test {
+public:
+    static constexpr size_t RING_SIZE = 16;
+    static constexpr int THREADS = 2;    //few threads: low hazard pointers scan threshold
+    Q queue;
+
+    Pool_Traits() : queue(RING_SIZE,THREADS){}
+};
+
+using PQueuesOfInts = PooledQueues<int>;
+
+TYPED_TEST_SUITE(Pool_Traits, PQueuesOfInts);
+
+/**
+ * Segments retired by the consumers are handed to the pool and reused
+ * by the producers: recycled segments must behave like fresh ones
+ */
+TYPED_TEST(Pool_Traits, RecycleSegments){
+    TypeParam& queue = this->queue;
+    const size_t items = this->RING_SIZE * 5;
+    std::vector<int> values(items);
+    for(size_t i = 0; i < items; i++)
+        values[i] = i + 1;
+
+    for(int run = 0; run < 10; run++){
+        for(size_t i = 0; i < items; i++)
+            queue.push(&values[i], 0);
+
+        for(size_t i = 0; i < items; i++)
+            EXPECT_EQ(queue.pop(0), &values[i]) << "Failed at extraction " << i << " of run " << run;
+        EXPECT_EQ(queue.pop(0), nullptr);
+        EXPECT_EQ(queue.length(0), 0);
+    }
+
+#ifndef DISABLE_HAZARD
+    EXPECT_GT(queue.getPoolHits(), 0);
+#endif
+}
+
+// Test setup for reclamation policies that bound the memory pinned by stalled threads
+template <typename Q>
+class Stalled_Traits : public ::testing::Test {
+public:
+    static constexpr size_t RING_SIZE = 16;
+    static constexpr int THREADS = 2;
+    Q queue;
+
+    Stalled_Traits() : queue(RING_SIZE,THREADS){}
+};
+
+using SQueuesOfInts = BoundedMemoryQueues<int>;
+
+TYPED_TEST_SUITE(Stalled_Traits, SQueuesOfInts);
+
+/**
+ * Thread 1 stalls in the middle of a pop while thread 0 keeps
+ * moving items through many segments: the segments allocated after
+ * the stall must be reclaimed anyway
+ */
+TYPED_TEST(Stalled_Traits, ReclaimWhileStalled){
+    TypeParam& queue = this->queue;
+    const size_t items = this->RING_SIZE * 64;
+    std::vector<int> values(items);
+    for(size_t i = 0; i < items; i++)
+        values[i] = i + 1;
+
+    queue.stalledPop(1,[&queue,&values,items](){
+        for(size_t i = 0; i < items; i++)
+            queue.push(&values[i], 0);
+        for(size_t i = 0; i < items; i++)
+            EXPECT_EQ(queue.pop(0), &values[i]) << "Failed at extraction " << i;
+        EXPECT_GT(queue.getReclaimStats().reclaimed, 0);
+    });
+    EXPECT_EQ(queue.pop(0), nullptr);
+}
+
+// Test setup for many queues attached to one reclamation domain
+template <typename Q>
+class SharedDomain_Traits : public ::testing::Test {
+public:
+    static constexpr size_t RING_SIZE = 16;
+    static constexpr int THREADS = 4;
+    static constexpr int QUEUES = 32;
+    std::shared_ptr<typename Q::Domain> domain = Q::makeDomain(THREADS);
+    std::vector<std::unique_ptr<Q>> queues;
+
+    SharedDomain_Traits(){
+        for(int i = 0; i < QUEUES; i++)
+            queues.push_back(std::make_unique<Q>(RING_SIZE,domain));
+    }
+};
+
+using SDQueuesOfInts = SharedDomainQueues<int>;
+
+TYPED_TEST_SUITE(SharedDomain_Traits, SDQueuesOfInts);
+
+/**
+ * A single handle is used on all the queues of the domain: segments
+ * retired by any queue are reclaimed, also after the queue is destroyed
+ */
+TYPED_TEST(SharedDomain_Traits, ReclaimAcrossQueues){
+    auto& queues = this->queues;
+    auto h = TypeParam::registerThread(*this->domain);
+    const size_t items = this->RING_SIZE * 8;
+    std::vector<int> values(items);
+    for(size_t i = 0; i < items; i++)
+        values[i] = i + 1;
+
+    for(int run = 0; run < 4; run++){
+        for(auto& queue : queues){
+            for(size_t i = 0; i < items; i++)
+                queue->push(&values[i], h);
+        }
+        for(auto& queue : queues){
+            for(size_t i = 0; i < items; i++)
+                EXPECT_EQ(queue->pop(h), &values[i]) << "Failed at extraction " << i << " of run " << run;
+            EXPECT_EQ(queue->pop(h), nullptr);
+        }
+        queues.pop_back();  //its retired segments stay in the domain
+    }
+    EXPECT_GT(this->domain->getStats().reclaimed, 0);
+    EXPECT_EQ(queues.front()->getReclaimStats().reclaimed, this->domain->getStats().reclaimed);
+}
+
+// Test setup for consumers parked on popWait
+template <typename Q>
+class Blocking_Traits : public ::testing::Test {
+public:
+    static constexpr size_t RING_SIZE = 16;
+    static constexpr int THREADS = 8;
+    Q queue;
+
+    Blocking_Traits() : queue(RING_SIZE,THREADS){}
+};
+
+using BlQueuesOfUserData = BlockingQueues<UserData>;
+
+TYPED_TEST_SUITE(Blocking_Traits, BlQueuesOfUserData);
+
+TYPED_TEST(Blocking_Traits, PopWaitTimeout){
+    TypeParam& queue = this->queue;
+    UserData ud{0,1};
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(queue.popWait(0,std::chrono::milliseconds{5}), nullptr);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{5});
+
+    queue.push(&ud,0);
+    EXPECT_EQ(queue.popWait(0,std::chrono::milliseconds{5}), &ud);
+}
+
+/**
+ * Consumers wait without timeout: every push (even after a pause of
+ * the producers) must wake a parked consumer, no item is lost
+ */
+TYPED_TEST(Blocking_Traits, WakeParkedConsumers){
+    TypeParam& queue = this->queue;
+    const int consumers = 4;
+    const int perConsumer = 500;
+    const int items = consumers * perConsumer;
+    std::vector<UserData> values;
+    for(int i = 0; i < items; i++)
+        values.push_back(UserData{0,(size_t)i + 1});
+    std::vector<uint64_t> sum(consumers,0);
+
+    std::vector<std::thread> threads;
+    for(int c = 0; c < consumers; c++){
+        threads.emplace_back([&queue,&sum,c,perConsumer](){
+            for(int i = 0; i < perConsumer; i++)
+                sum[c] += queue.popWait(c + 1)->id;
+        });
+    }
+    for(int i = 0; i < items; i++){
+        if(i % 100 == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds{2});     //lets the consumers park
+        if constexpr (std::is_same_v<decltype(queue.push(&values[i],0)),bool>)
+            while(!queue.push(&values[i],0))    //bounded queue: full until a consumer runs
+                std::this_thread::yield();
+        else
+            queue.push(&values[i],0);
+    }
+    for(auto& t : threads)
+        t.join();
+
+    uint64_t total = std::accumulate(sum.begin(),sum.end(),0ull);
+    EXPECT_EQ(total, (uint64_t)items * (items + 1) / 2);
+    EXPECT_EQ(queue.pop(0), nullptr);
+}
+
+// Test setup for producers parked on pushWait (bounded queues)
+template <typename Q>
+class Backpressure_Traits : public ::testing::Test {
+public:
+    static constexpr size_t RING_SIZE = 8;
+    Q queue;
+
+    Backpressure_Traits() : queue(RING_SIZE){}
+};
+
+TYPED_TEST_SUITE(Backpressure_Traits, BQueuesOfUserData);
+
+TYPED_TEST(Backpressure_Traits, PushWaitTimeout){
+    TypeParam& queue = this->queue;
+    std::vector<UserData> values(this->RING_SIZE * 2);
+    size_t pushed = 0;
+    while(queue.push(&values[pushed],0))
+        pushed++;
+    ASSERT_GT(pushed, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(queue.pushWait(&values[pushed],0,std::chrono::milliseconds{5}));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{5});
+
+    EXPECT_EQ(queue.pop(0), &values[0]);
+    EXPECT_TRUE(queue.pushWait(&values[pushed],0,std::chrono::milliseconds{5}));
+}
+
+/**
+ * Producers block on a small ring while a slow consumer drains it:
+ * every pop must wake a parked producer, no item is lost
+ */
+TYPED_TEST(Backpressure_Traits, WakeParkedProducers){
+    TypeParam& queue = this->queue;
+    const int producers = 4;
+    const int perProducer = 500;
+    std::vector<std::vector<UserData>> items(producers);
+    for(int p = 0; p < producers; p++){
+        for(int i = 0; i < perProducer; i++)
+            items[p].push_back(UserData{p,(size_t)i + 1});
+    }
+
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; p++){
+        threads.emplace_back([&queue,&items,p](){
+            for(UserData& ud : items[p])
+                queue.pushWait(&ud,p + 1);
+        });
+    }
+    uint64_t sum = 0;
+    for(int i = 0; i < producers * perProducer; i++){
+        if(i % 100 == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds{2});     //lets the producers park
+        UserData* ud = nullptr;
+        while((ud = queue.pop(0)) == nullptr)
+            std::this_thread::yield();
+        sum += ud->id;
+    }
+    for(auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(sum, (uint64_t)producers * perProducer * (perProducer + 1) / 2);
+    EXPECT_EQ(queue.pop(0), nullptr);
+}
+
+// Test setup for single producer / single consumer queues
+template <typename Q>
+class SPSC_Traits : public ::testing::Test {
+public:
+    static constexpr size_t RING_SIZE = 16;
+    static constexpr bool bounded = std::is_same_v<decltype(std::declval<Q&>().push(nullptr,0)),bool>;
+    Q queue;
+
+    SPSC_Traits() : queue(RING_SIZE){}
+};
+
+using SPSCQueuesOfUserData = SPSCQueues<UserData>;
+
+TYPED_TEST_SUITE(SPSC_Traits, SPSCQueuesOfUserData);
+
+TYPED_TEST(SPSC_Traits, FifoOrder){
+    TypeParam& queue = this->queue;
+    const size_t count = this->bounded? this->RING_SIZE : this->RING_SIZE * 10;   //the linked queue spans several rings
+    std::vector<UserData> values(count);
+    for(size_t i = 0; i < count; i++){
+        values[i] = UserData{0,i};
+        if constexpr (TestFixture::bounded){
+            ASSERT_TRUE(queue.push(&values[i],0));
+        }
+        else{
+            queue.push(&values[i],0);
+        }
+    }
+    EXPECT_EQ(queue.length(0), count);
+    if constexpr (TestFixture::bounded){
+        EXPECT_FALSE(queue.push(&values[0],0));
+    }
+
+    for(size_t i = 0; i < count; i++){
+        ASSERT_EQ(queue.pop(0), &values[i]);
+        if(i == count / 2){  //head and tail on different rings
+            EXPECT_EQ(queue.length(0), count - i - 1);
+        }
+    }
+    EXPECT_EQ(queue.pop(0), nullptr);
+    EXPECT_EQ(queue.length(0), 0);
+}
+
+TYPED_TEST(SPSC_Traits, NullItem){
+    EXPECT_THROW(this->queue.push(nullptr,0), std::invalid_argument);
+    EXPECT_EQ(this->queue.length(0), 0);
+}
+
+/**
+ * One producer and one consumer running concurrently:
+ * the consumer must see every item exactly once and in push order,
+ * the producer reads the length meanwhile
+ */
+TYPED_TEST(SPSC_Traits, ConcurrentTransfer){
+    TypeParam& queue = this->queue;
+    const size_t count = 200000;
+    std::vector<UserData> values(count);
+    for(size_t i = 0; i < count; i++)
+        values[i] = UserData{0,i};
+
+    std::thread producer([&queue,&values,count](){
+        for(UserData& ud : values){
+            if constexpr (TestFixture::bounded){
+                while(!queue.push(&ud,0))
+                    std::this_thread::yield();
+            }
+            else queue.push(&ud,0);
+            EXPECT_LE(queue.length(0), count);   //the consumer keeps recycling the rings it leaves
+        }
+    });
+    for(size_t i = 0; i < count; i++){
+        UserData* ud = nullptr;
+        while((ud = queue.pop(1)) == nullptr)
+            std::this_thread::yield();
+        ASSERT_EQ(ud->id, i);
+    }
+    producer.join();
+    EXPECT_EQ(queue.pop(1), nullptr);
+}
+
+// Test setup for multi producer / single consumer queues
+template <typename Q>
+class MPSC_Traits : public ::testing::Test {
+public:
+    static constexpr size_t RING_SIZE = 16;
+    static constexpr int THREADS = 8;
+    Q queue;
+
+    MPSC_Traits() : queue(RING_SIZE,THREADS){}
+};
+
+using MPSCQueuesOfUserData = MPSCQueues<UserData>;
+
+TYPED_TEST_SUITE(MPSC_Traits, MPSCQueuesOfUserData);
+
+TYPED_TEST(MPSC_Traits, FifoOrder){
+    TypeParam& queue = this->queue;
+    const size_t count = this->RING_SIZE * 10;
+    std::vector<UserData> values(count);
+    for(size_t i = 0; i < count; i++){
+        values[i] = UserData{0,i};
+        queue.push(&values[i],0);
+    }
+    EXPECT_EQ(queue.length(0), count);
+    for(size_t i = 0; i < count; i++)
+        ASSERT_EQ(queue.pop(0), &values[i]);
+    EXPECT_EQ(queue.pop(0), nullptr);
+    EXPECT_EQ(queue.length(0), 0);
+}
+
+/**
+ * Many producers and one consumer: every item is popped exactly once
+ * and the items of each producer come out in push order
+ */
+TYPED_TEST(MPSC_Traits, ManyProducersOneConsumer){
+    TypeParam& queue = this->queue;
+    const int producers = this->THREADS - 1;
+    const size_t perProducer = 20000;
+    std::vector<std::vector<UserData>> items(producers);
+    for(int p = 0; p < producers; p++){
+        for(size_t i = 0; i < perProducer; i++)
+            items[p].push_back(UserData{p,i});
+    }
+
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; p++){
+        threads.emplace_back([&queue,&items,p](){
+            for(UserData& ud : items[p])
+                queue.push(&ud,p + 1);
+        });
+    }
+    std::vector<size_t> expected(producers,0);
+    for(size_t i = 0; i < producers * perProducer; i++){
+        UserData* ud = nullptr;
+        while((ud = queue.pop(0)) == nullptr)
+            std::this_thread::yield();
+        ASSERT_EQ(ud->id, expected[ud->tid]++) << "Out of order item of producer " << ud->tid;
+    }
+    for(auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(queue.pop(0), nullptr);
+    EXPECT_EQ(queue.length(0), 0);
+}
+
+struct LinkedData : MPSCHook {
+    size_t id;
+};
+
+//items deriving from MPSCHook are linked through their own hook (no node per push)
+TEST(MPSCQueue_Intrusive, LinkThroughHook){
+    MPSCQueue<LinkedData> queue(0,2);
+    std::vector<LinkedData> values(100);
+    for(int run = 0; run < 3; run++){
+        for(size_t i = 0; i < values.size(); i++){
+            values[i].id = i;
+            queue.push(&values[i],1);
+        }
+        for(size_t i = 0; i < values.size(); i++)
+            ASSERT_EQ(queue.pop(0), &values[i]);
+        EXPECT_EQ(queue.pop(0), nullptr);
+        EXPECT_EQ(queue.length(0), 0);
+    }
+}
+
+/**
+ * Tiny segments: the threads keep allocating, helping and reclaiming segments;
+ * every item is popped once and the items of a producer come out in order
+ */
+TEST(WFQueue_Helping, PerProducerOrder){
+    constexpr int PRODUCERS = 4, CONSUMERS = 4;
+    constexpr int ITEMS = 20000;    //per producer
+    WFQueue<UserData> queue(2,PRODUCERS + CONSUMERS);
+    std::vector<std::vector<UserData>> items(PRODUCERS,std::vector<UserData>(ITEMS));
+    std::atomic<int> popped{0};
+    std::atomic<bool> ordered{true};
+    std::barrier<> barrier(PRODUCERS + CONSUMERS);
+
+    ThreadGroup threads{};
+    for(int p = 0; p < PRODUCERS; p++){
+        threads.thread([&,p](const int tid){
+            for(int i = 0; i < ITEMS; i++)
+                items[p][i] = UserData{p,static_cast<size_t>(i)};
+            barrier.arrive_and_wait();
+            for(int i = 0; i < ITEMS; i++)
+                queue.push(&items[p][i],tid);
+        });
+    }
+    for(int c = 0; c < CONSUMERS; c++){
+        threads.thread([&](const int tid){
+            std::vector<long> last(PRODUCERS,-1);
+            barrier.arrive_and_wait();
+            while(popped.load() < PRODUCERS * ITEMS){
+                UserData* d = queue.pop(tid);
+                if(d == nullptr) continue;
+                if(static_cast<long>(d->id) <= last[d->tid]) ordered.store(false);
+                last[d->tid] = d->id;
+                popped.fetch_add(1);
+            }
+        });
+    }
+    threads.join();
+
+    EXPECT_TRUE(ordered.load());
+    EXPECT_EQ(popped.load(), PRODUCERS * ITEMS);
+    EXPECT_EQ(queue.pop(0), nullptr);
+}
+
+/**
+ * Items pushed on every home shard are all popped by one consumer (stealing),
+ * in FIFO order per producer
+ */
+TEST(ShardedQueue_Steal, PopsEveryShard){
+    constexpr int PRODUCERS = 6;
+    constexpr size_t ITEMS = 50;
+    ShardedLCRQueue<UserData> queue(128,PRODUCERS + 1,4);
+    std::vector<std::vector<UserData>> items(PRODUCERS);
+    for(int p = 0; p < PRODUCERS; p++){
+        for(size_t i = 0; i < ITEMS; i++)
+            items[p].push_back(UserData{p,i});
+    }
+    for(size_t i = 0; i < ITEMS; i++){
+        for(int p = 0; p < PRODUCERS; p++)
+            queue.push(&items[p][i],p);
+    }
+    EXPECT_EQ(queue.length(0), PRODUCERS * ITEMS);
+
+    std::vector<long> last(PRODUCERS,-1);
+    for(size_t n = 0; n < PRODUCERS * ITEMS; n++){
+        UserData* d = queue.pop(PRODUCERS);
+        ASSERT_NE(d, nullptr);
+        EXPECT_GT(static_cast<long>(d->id), last[d->tid]);
+        last[d->tid] = d->id;
+    }
+    EXPECT_EQ(queue.pop(PRODUCERS), nullptr);
+    EXPECT_EQ(queue.length(0), 0);
+}
+
+/**
+ * Without NUMA the queue is a single shard; with more nodes than the machine
+ * has every item still goes through the local node in FIFO order
+ */
+TEST(NumaShardedQueue_Nodes, LocalFirst){
+    NumaLCRQueue<UserData> single(16,2);
+    EXPECT_EQ(single.getShards(), static_cast<size_t>(getNumaNodes()));
+
+    NumaLCRQueue<UserData> queue(128,2,3);
+    ASSERT_EQ(queue.getShards(), 3);
+    std::vector<UserData> items;
+    for(size_t i = 0; i < 100; i++)
+        items.push_back(UserData{0,i});
+    for(auto& item : items)
+        queue.push(&item,0);
+    EXPECT_EQ(queue.length(1), items.size());
+    for(size_t i = 0; i < items.size(); i++){
+        UserData* d = queue.pop(1);
+        ASSERT_NE(d, nullptr);
+        EXPECT_EQ(d->id, i);
+    }
+    EXPECT_EQ(queue.pop(1), nullptr);
+}
+
+//node of the calling thread for the emulated NUMA machine of the tests
+thread_local int emulatedNode = 0;
+int emulatedNumaNode(){ return emulatedNode; }
+
+/**
+ * Two emulated nodes: consumers drain their local node first, then steal the
+ * items of the remote node (FIFO per node), every item is popped once
+ */
+TEST(NumaShardedQueue_Nodes, StealsFromRemoteNode){
+    using Queue = ShardedQueue<UserData,LCRQueue,NumaNodeShard<emulatedNumaNode>>;
+    constexpr size_t ITEMS = 100;
+    std::vector<UserData> local, remote;
+    for(size_t i = 0; i < ITEMS; i++){
+        local.push_back(UserData{0,i});
+        remote.push_back(UserData{1,i});
+    }
+
+    Queue queue(64,4,2);
+    ASSERT_EQ(queue.getShards(), 2);
+    std::thread([&](){
+        emulatedNode = 1;
+        for(auto& item : remote)
+            queue.push(&item,1);
+    }).join();
+    for(auto& item : local)
+        queue.push(&item,0);
+    for(size_t i = 0; i < 2 * ITEMS; i++){
+        UserData* d = queue.pop(0);
+        ASSERT_NE(d, nullptr);
+        EXPECT_EQ(d->tid, i < ITEMS ? 0 : 1);   //local node first
+        EXPECT_EQ(d->id, i % ITEMS);
+    }
+    EXPECT_EQ(queue.pop(0), nullptr);
+
+    //producers on both nodes, consumers on node 0 only
+    constexpr int PRODUCERS = 2, CONSUMERS = 2;
+    constexpr size_t PER_PRODUCER = 20000;
+    Queue shared(64,PRODUCERS + CONSUMERS,2);
+    std::vector<std::vector<UserData>> items(PRODUCERS);
+    for(int p = 0; p < PRODUCERS; p++){
+        for(size_t i = 0; i < PER_PRODUCER; i++)
+            items[p].push_back(UserData{p,i});
+    }
+    std::vector<std::atomic<int>> seen(PRODUCERS * PER_PRODUCER);
+    std::atomic<size_t> popped{0};
+    ThreadGroup threads;
+    for(int p = 0; p < PRODUCERS; p++){
+        threads.thread([&,p](int){
+            emulatedNode = p;
+            for(auto& item : items[p])
+                shared.push(&item,p);
+        });
+    }
+    for(int c = 0; c < CONSUMERS; c++){
+        threads.thread([&,c](int){
+            emulatedNode = 0;
+            while(popped.load() < PRODUCERS * PER_PRODUCER){
+                if(UserData* d = shared.pop(PRODUCERS + c)){
+                    seen[d->tid * PER_PRODUCER + d->id].fetch_add(1);
+                    popped.fetch_add(1);
+                }
+            }
+        });
+    }
+    threads.join();
+    for(auto& count : seen)
+        ASSERT_EQ(count.load(), 1);
+    EXPECT_EQ(shared.pop(0), nullptr);
+}
+
+/**
+ * Every placement policy returns aligned cells (first touch without libnuma)
+ */
+TEST(NumaArray_Placement, EveryPolicy){
+    using Cell = detail::CRQCell<int*,true>;
+    for(NumaPolicy policy : {NumaPolicy::FirstTouch,NumaPolicy::Local,NumaPolicy::Interleave,NumaPolicy::Bind}){
+        detail::NumaArray<Cell> cells(100,policy,0);
+        ASSERT_EQ(cells.size(), 100);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(cells.data()) % alignof(Cell), 0);
+        EXPECT_EQ(cells.onNuma(), policy != NumaPolicy::FirstTouch && isNumaAvailable());
+        for(size_t i = 0; i < cells.size(); i++)
+            cells[i].idx.store(i);
+        detail::NumaArray<Cell> moved = std::move(cells);
+        EXPECT_EQ(cells.data(), nullptr);
+        EXPECT_EQ(moved[99].idx.load(), 99);
+    }
+}
+
+/**
+ * The remapping is a permutation of the ring and consecutive positions never
+ * share a cache line (power of two and generic ring sizes)
+ */
+TEST(CellRemap_Layout, ConsecutiveOnDifferentLines){
+    using Cell = detail::CRQCell<int*,false>;
+    constexpr size_t perLine = CACHE_LINE / sizeof(Cell);
+    for(size_t size : {8ul,64ul,1024ul,20ul,96ul}){
+        detail::CellRemap<Cell,true> remap(size);
+        ASSERT_TRUE(remap.active()) << size;
+        std::vector<bool> used(size,false);
+        for(size_t pos = 0; pos < size; pos++){
+            const size_t cell = remap(pos);
+            ASSERT_LT(cell, size);
+            EXPECT_FALSE(used[cell]) << "size " << size << " position " << pos;
+            used[cell] = true;
+            if(pos > 0){
+                EXPECT_NE(cell / perLine, remap(pos - 1) / perLine) << "size " << size << " position " << pos;
+            }
+        }
+    }
+    using Remap = detail::CellRemap<Cell,true>;
+    EXPECT_FALSE(Remap(6).active());    //not a multiple of the cells per line
+    EXPECT_FALSE(Remap(4).active());    //a single line
+    EXPECT_FALSE((detail::CellRemap<detail::CRQCell<int*,true>,true>(64).active()));  //padded cells
+    EXPECT_EQ((detail::CellRemap<Cell,false>(64)(5)), 5);
+}
+
+/**
+ * The exponential backoffs saturate to BACKOFF_MAX (they must not wrap to 0)
+ */
+TEST(Backoff_Policies, Saturate){
+    ExpBackoff exp;
+    JitterBackoff jitter;
+    YieldBackoff yield;
+    for(int i = 0; i < 16; i++){
+        exp.wait();
+        jitter.wait();
+        yield.wait();
+    }
+    EXPECT_EQ(exp.current, BACKOFF_MAX);
+    EXPECT_EQ(jitter.current, BACKOFF_MAX);
+    EXPECT_EQ(yield.failures, 16);
+    EXPECT_EQ(BoundedMTQueueJitter<int>::className(), "BoundedMTQueue/jitter/padded");
+}
+
+/**
+ * Threads of two nodes sharing a segment both complete: the owner node hands
+ * off (or the waiting node takes the segment from an idle owner)
+ */
+TEST(ClusterCohort_Handoff, BothNodesProgress){
+    constexpr size_t OPS = 20000;
+    detail::ClusterCohort cohort;
+    cohort.reset(0);
+    std::atomic<size_t> done[2] = {0,0};
+    ThreadGroup threads;
+    for(uint64_t node = 0; node < 2; node++){
+        threads.thread([&,node](int){
+            for(size_t i = 0; i < OPS; i++){
+                cohort.acquire(node);
+                done[node].fetch_add(1);
+            }
+        });
+    }
+    threads.join();
+    EXPECT_EQ(done[0].load(), OPS);
+    EXPECT_EQ(done[1].load(), OPS);
+    EXPECT_GE(cohort.getHandoffs(), 1);
+}
+
+/**
+ * Cluster mode selected by name at runtime (benchmark argument): the
+ * queues work in both modes, the segments keep the mode they were built with
+ */
+TEST(ClusterCohort_Handoff, RuntimeMode){
+    EXPECT_EQ(parseClusterMode("Cohort"), ClusterMode::Cohort);
+    EXPECT_EQ(parseClusterMode(clusterModeName(ClusterMode::Off)), ClusterMode::Off);
+    EXPECT_THROW(parseClusterMode("On"), std::invalid_argument);
+
+    std::vector<int> items(100);
+    for(ClusterMode mode : {ClusterMode::Cohort, ClusterMode::Off}){
+        setClusterMode(mode);
+        EXPECT_EQ(getClusterMode(), mode);
+        LCRQueue<int> queue(16,1);
+        setClusterMode(mode == ClusterMode::Off ? ClusterMode::Cohort : ClusterMode::Off);   //the segments keep their mode
+        for(int& item : items)
+            queue.push(&item,0);
+        for(int& item : items)
+            ASSERT_EQ(queue.pop(0), &item);
+    }
+    setClusterMode(ClusterMode::Off);
+}
+
+/**
+ * Ring size fixed at compile time: the runtime size is ignored, the cells are
+ * embedded in the segment and non power of 2 sizes use a constant modulo
+ */
+TEST(FixedRingSize_Segments, CompileTimeSize){
+    constexpr size_t N = 48;
+    static_assert(sizeof(CRQueue<int,true,true,N>) >= N * CACHE_LINE);
+    EXPECT_EQ((detail::RingSize<N>::position(N + 5)), 5);
+    EXPECT_EQ((detail::RingSize<64>::position(64 + 5)), 5);
+    EXPECT_EQ(BoundedMTQueueFixed<int>::className(), "BoundedMTQueue/padded/fixed4096");
+
+    CRQueue<int,true,true,N> crq(8);
+    PRQueue<int,false,true,N> prq(8);
+    MTQueue<int,true,true,N> mtq(8);
+    std::vector<int> items(N);
+    for(int round = 0; round < 3; round++){
+        for(size_t i = 0; i < N; i++){
+            ASSERT_TRUE(crq.push(&items[i]));
+            ASSERT_TRUE(prq.push(&items[i]));
+            ASSERT_TRUE(mtq.push(&items[i],0));
+        }
+        EXPECT_FALSE(crq.push(&items[0]));
+        EXPECT_FALSE(prq.push(&items[0]));
+        EXPECT_FALSE(mtq.push(&items[0],0));
+        EXPECT_EQ(crq.length(), N);
+        for(size_t i = 0; i < N; i++){
+            ASSERT_EQ(crq.pop(), &items[i]);
+            ASSERT_EQ(prq.pop(), &items[i]);
+            ASSERT_EQ(mtq.pop(0), &items[i]);
+        }
+    }
+
+    LinkedRingQueue<int,CRQueue<int,true,false,16>> linked(1024);   //segments of 16 cells
+    for(size_t i = 0; i < N; i++)
+        linked.push(&items[i],0);
+    for(size_t i = 0; i < N; i++)
+        ASSERT_EQ(linked.pop(0), &items[i]);
+    EXPECT_EQ(linked.pop(0), nullptr);
+}
+
+/**
+ * Single block segments: the cells follow the segment in the same aligned
+ * allocation, and unbounded segments can only be allocated by LinkedRingQueue
+ */
+TEST(SingleBlock_Segments, CellsFollowTheSegment){
+    using Cell = detail::CRQCell<int*,false>;
+    struct alignas(CACHE_LINE) Header : detail::SingleBlock<Cell,CACHE_LINE> {
+        std::atomic<uint64_t> head{0};
+    };
+    Header* header = new (detail::RingCells{32}) Header();
+    Cell* cells = detail::trailingCells<Cell>(header);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(header) % CACHE_LINE, 0);
+    EXPECT_EQ(reinterpret_cast<char*>(cells), reinterpret_cast<char*>(header) + sizeof(Header));
+    for(size_t i = 0; i < 32; i++)
+        EXPECT_EQ(cells[i].val.load(), nullptr);
+    cells[31].idx.store(31);
+    delete header;
+
+    static_assert(!std::is_constructible_v<CRQueue<int,true,false>,size_t>);
+    static_assert(!std::is_constructible_v<MTQueue<int,true,false>,size_t>);
+    static_assert(std::is_constructible_v<CRQueue<int,true,true>,size_t>);
+    static_assert(std::is_constructible_v<PRQueue<int,true,false,64>,size_t>);  //cells embedded
+
+    LCRQueue<int> linked(8);
+    std::vector<int> items(100);
+    for(int& item : items)
+        linked.push(&item,0);   //13 segments
+    for(int& item : items)
+        ASSERT_EQ(linked.pop(0), &item);
+}
+
+/**
+ * Compact CRQ: 8 byte cells (single word CAS) and payload slots reused
+ * over many rounds of a small ring
+ */
+TEST(CompactCRQueue_Cells, SingleWordRounds){
+    EXPECT_EQ(sizeof(detail::CompactCell), 8);
+    EXPECT_EQ(BoundedCompactCRQueue<int>::bytesPerSlot(), 16);
+    EXPECT_EQ(LCompactCRQueue<int>::className(), "LinkedCompactCRQueue");
+
+    BoundedCompactCRQueue<int> queue(4);
+    std::vector<int> items(8);
+    std::iota(items.begin(),items.end(),0);
+    for(int round = 0; round < 100; round++){
+        for(int i = 0; i < 4; i++)
+            ASSERT_TRUE(queue.push(&items[(round + i) % 8]));
+        EXPECT_FALSE(queue.push(&items[0]));
+        for(int i = 0; i < 4; i++)
+            ASSERT_EQ(queue.pop(), &items[(round + i) % 8]);
+        EXPECT_EQ(queue.pop(), nullptr);
+    }
+}
+
+/**
+ * Inline queues: values in FIFO order across the segments, the empty
+ * sentinel can't be pushed and every other value (0 included) can
+ */
+TEST(InlineQueue_Values, SentinelAndOrder){
+    struct Pair { int32_t a; int32_t b; };
+    InlineLCRQueue<uint32_t> linked(128);
+    uint32_t value = 0;
+    EXPECT_THROW(linked.push(0u,0), std::invalid_argument);
+    for(uint32_t i = 1; i <= 100; i++)
+        linked.push(i,0);
+    EXPECT_EQ(linked.length(0), 100);
+    for(uint32_t i = 101; i <= 300; i++)  //next segments
+        linked.push(i,0);
+    for(uint32_t i = 1; i <= 300; i++){
+        ASSERT_TRUE(linked.pop(value,0));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(linked.pop(value,0));
+
+    InlineLMTQueue<int32_t> withSentinel(16,128,-1);
+    int32_t signedValue = -1;
+    EXPECT_THROW(withSentinel.push(-1,0), std::invalid_argument);
+    withSentinel.push(0,0);
+    ASSERT_TRUE(withSentinel.pop(signedValue,0));
+    EXPECT_EQ(signedValue, 0);
+
+    InlineBoundedCRQueue<Pair> bounded(8);
+    int pushed = 0;
+    while(bounded.push(Pair{pushed,-pushed - 1},0))
+        pushed++;
+    EXPECT_EQ(pushed, 8);
+    Pair pair{};
+    for(int i = 0; i < pushed; i++){
+        ASSERT_TRUE(bounded.pop(pair,0));
+        EXPECT_EQ(pair.a, i);
+        EXPECT_EQ(pair.b, -i - 1);
+    }
+    EXPECT_FALSE(bounded.pop(pair,0));
+    EXPECT_EQ(InlineBoundedMTQueue<uint64_t>::className(), "InlineBoundedMTQueue/padded");
+}
+
+/**
+ * Values of 8 (InlineQueue) and 16 bytes (BoundedValueQueue) are transferred
+ * exactly once by concurrent producers and consumers
+ */
+TEST(InlineQueue_Values, ConcurrentTransfer){
+    struct Wide { uint64_t producer; uint64_t seq; };
+    constexpr int producers = 3;
+    constexpr int consumers = 3;
+    constexpr uint64_t iter = 5000;
+    const auto transfer = [](auto& queue, auto make, auto key){
+        std::atomic<int> running{producers};
+        std::vector<uint64_t> sum(consumers,0);
+        ThreadGroup threads;
+        for(int p = 0; p < producers; p++){
+            threads.thread([&,p](int tid){
+                for(uint64_t i = 1; i <= iter; i++){
+                    if constexpr (requires{ { queue.push(make(p,i),tid) } -> std::same_as<bool>; }){
+                        while(!queue.push(make(p,i),tid));
+                    } else queue.push(make(p,i),tid);
+                }
+                running.fetch_sub(1);
+            });
+        }
+        for(int c = 0; c < consumers; c++){
+            threads.thread([&,c](int tid){
+                decltype(make(0,0)) value{};
+                while(true){
+                    const bool done = running.load() == 0;  //read before the pop: no push can follow
+                    if(queue.pop(value,tid))
+                        sum[c] += key(value);
+                    else if(done)
+                        break;
+                }
+            });
+        }
+        threads.join();
+        return std::accumulate(sum.begin(),sum.end(),0ull);
+    };
+    const uint64_t expected = producers * iter * (iter + 1) / 2;
+
+    InlineLCRQueue<uint64_t> narrow(64,producers + consumers);
+    EXPECT_EQ(transfer(narrow,[](int,uint64_t i){ return i; },[](uint64_t v){ return v; }), expected);
+
+    BoundedValueQueue<Wide> wide(64,producers + consumers);
+    static_assert(sizeof(Wide) == 16);
+    EXPECT_EQ(transfer(wide,[](int p,uint64_t i){ return Wide{(uint64_t)p,i}; },[](const Wide& w){ return w.seq; }), expected);
+    EXPECT_EQ(wide.length(), 0);
+}
+
+// Test setup for queues used through registration handles instead of tids
+template <typename Q>
+class Registration_Traits : public ::testing::Test {
+public:
+    static constexpr size_t RING_SIZE = 16;
+    static constexpr int THREADS = 300;     //more than the default number of slots
+    Q queue;
+
+    Registration_Traits() : queue(RING_SIZE,THREADS){}
+};
+
+using RQueuesOfUserData = RegisteringQueues<UserData>;
+
+TYPED_TEST_SUITE(Registration_Traits, RQueuesOfUserData);
+
+/**
+ * Slots beyond the default MAX_THREADS are usable, and a slot
+ * released by a handle is handed to the next registered thread
+ */
+TYPED_TEST(Registration_Traits, RecycleSlots){
+    TypeParam& queue = this->queue;
+    const int last = this->THREADS - 1;
+    UserData a{0,1}, b{0,2};
+
+    queue.push(&a, last);
+    EXPECT_EQ(queue.pop(last), &a);
+
+    int tid = -1;
+    {
+        auto h = queue.registerThread();
+        tid = h.tid();
+        EXPECT_GE(tid, 0);
+        EXPECT_LT(tid, this->THREADS);
+        queue.push(&b, h);
+        EXPECT_EQ(queue.length(h), 1);
+        EXPECT_EQ(queue.pop(h), &b);
+        EXPECT_EQ(queue.pop(h), nullptr);
+    }
+    auto h = queue.registerThread();
+    EXPECT_EQ(h.tid(), tid);
+
+    //all slots taken (the fixed ones are never released)
+    std::vector<typename TypeParam::Handle> handles;
+    EXPECT_THROW(while(true) handles.push_back(queue.registerThread()), std::runtime_error);
+}
+
+/**
+ * Threads register on their own (no tid is passed around):
+ * every item is transferred exactly once
+ */
+TYPED_TEST(Registration_Traits, TransferAllItems){
+    TypeParam& queue = this->queue;
+    const int producers = 4;
+    const int consumers = 4;
+    const int iter = 10000;
+    std::barrier<> threadsBarrier(producers + consumers);
+    std::atomic<bool> stopFlag{false};
+    std::vector<uint64_t> sum(consumers,0);
+    std::vector<std::vector<UserData>> items(producers);
+    for(int p = 0; p < producers; p++){
+        for(int i = 0; i < iter; i++)
+            items[p].push_back(UserData{p,(size_t)i + 1});
+    }
+
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; p++){
+        threads.emplace_back([&queue,&threadsBarrier,&items,p](){
+            auto h = queue.registerThread();
+            threadsBarrier.arrive_and_wait();
+            for(UserData& ud : items[p])
+                queue.push(&ud, h);
+        });
+    }
+    for(int c = 0; c < consumers; c++){
+        threads.emplace_back([&queue,&threadsBarrier,&stopFlag,&sum,c](){
+            auto h = queue.registerThread();
+            threadsBarrier.arrive_and_wait();
+            while(true){
+                UserData* ud = queue.pop(h);
+                if(ud != nullptr)
+                    sum[c] += ud->id;
+                else if(stopFlag.load())
+                    break;
+            }
+        });
+    }
+    for(int p = 0; p < producers; p++)
+        threads[p].join();
+    stopFlag.store(true);
+    for(int c = 0; c < consumers; c++)
+        threads[producers + c].join();
+
+    uint64_t total = std::accumulate(sum.begin(),sum.end(),0ull);
+    EXPECT_EQ(total, (uint64_t)producers * iter * (iter + 1) / 2);
+    EXPECT_EQ(queue.pop(queue.registerThread()), nullptr);
+}
+
+/**
+ * Hazard pointers storage is sized by maxThreads / maxHPs: with 2 hazard
+ * pointers every thread takes one cache line, and a retired pointer is
+ * reclaimed only when no (runtime sized) hazard slot protects it
+ */
+TEST(HazardPointers_Storage, SizeOnDemand){
+    EXPECT_EQ(HazardPointers<int>(2,4).footprint(), 4 * CACHE_LINE);
+    EXPECT_EQ(HazardPointers<int>(2,1000).footprint(), 1000 * CACHE_LINE);
+
+    const int hps = 16;
+    std::vector<int*> reclaimed;
+    {
+        HazardPointers<int> hp(hps,2,[&reclaimed](int* ptr){ reclaimed.push_back(ptr); delete ptr; });
+        auto owner = hp.slot(0);
+        auto other = hp.slot(1);
+        int* protectedPtr = new int(1);
+        hp.protect(hps - 1,protectedPtr,owner);
+        hp.retire(protectedPtr,other);
+        for(int i = 0; i < HP_SCAN_FACTOR * 2 * hps; i++)
+            hp.retire(new int(i),other);
+        EXPECT_GT(hp.getStats().scans, 0);
+        EXPECT_EQ(std::count(reclaimed.begin(),reclaimed.end(),protectedPtr), 0);
+        hp.clear(owner);
+    }
+}
+
+/**
+ * The item published by a starving producer is taken by exactly one helper
+ * (a consumer of the empty ring); the queues start with no slow path counted
+ */
+TEST(StarvingPush, ConsumerCompletesPush){
+    detail::StarvingPush<int> starving;
+    int item = 7;
+    std::atomic<bool> done{false};
+    std::thread producer([&](){
+        while(!starving.publish(&item));
+        done.store(true);
+    });
+    int* taken = nullptr;
+    while(taken == nullptr)
+        taken = starving.help();
+    producer.join();
+    EXPECT_EQ(taken, &item);
+    EXPECT_TRUE(done.load());
+    EXPECT_EQ(starving.help(), nullptr);
+    EXPECT_GE(starving.getStats().slowPushes, 1);
+    EXPECT_EQ(starving.getStats().helpedPushes, 1);
+
+    BoundedCRQueue<int> bounded(16);
+    EXPECT_EQ(bounded.getPushStats().slowPushes, 0);
+    LPRQueue<int> linked(16,2);
+    for(int i = 0; i < 100; i++)
+        linked.push(&item,0);
+    EXPECT_EQ(linked.getPushStats().forcedCloses, 0);
+}
+
+namespace detail{
+template<class S>
+struct SegmentProbe {
+    //unbounded segments are allocated by LinkedRingQueue only
+    static S* make(size_t size) {
+        if constexpr (S::singleBlock)
+            return new (RingCells{S::cellsFor(size)}) S(size,0,0);
+        else
+            return new S(size,0,0);
+    }
+
+    //consumers that took tickets on the empty ring and invalidated their cells, before fixing the tail
+    static void overrun(S& segment, uint64_t tickets) {
+        for(uint64_t i = 0; i < tickets; i++)
+            EXPECT_EQ(segment.dequeueTicket(segment.head.fetch_add(1)), nullptr);
+    }
+
+    //slow path of a producer whose ticket failed at the current tail: no ticket is taken, so that
+    //retrying does not leave void cells that the consumers have to invalidate before finding the ring empty
+    template<class T>
+    static SlowPush slowPush(S& segment, T* item) {
+        return segment.slowPush(item,segment.tail.load());
+    }
+};
+}
+
+/**
+ * Starving producer on the CRQ / PRQ segments:
+ * - overrun by the consumers it takes the slow path, nobody helps and it completes on the fast path
+ *   (push and pushBatch)
+ * - a consumer finding the ring empty returns the published item (once)
+ * - a full segment is force closed only after the producer took its item back
+ * - a batch never forces the close of a full segment on its own
+ */
+template<class Bounded, class Unbounded>
+void starvingSegmentPush(){
+    using BoundedProbe = detail::SegmentProbe<Bounded>;
+    using UnboundedProbe = detail::SegmentProbe<Unbounded>;
+    std::vector<int> items(4);
+
+    Bounded overrun(2);
+    BoundedProbe::overrun(overrun,8 * STARVATION_THRESHOLD);
+    EXPECT_TRUE(overrun.push(&items[0]));
+    EXPECT_GE(overrun.getPushStats().slowPushes, 8);
+    EXPECT_EQ(overrun.getPushStats().helpedPushes, 0);
+    EXPECT_EQ(overrun.pop(), &items[0]);
+    EXPECT_EQ(overrun.pop(), nullptr);
+
+    //a batch takes the same slow path for the item it keeps failing
+    const uint64_t slowPushes = overrun.getPushStats().slowPushes;
+    BoundedProbe::overrun(overrun,8 * STARVATION_THRESHOLD);
+    int* batch[2] = {&items[2],&items[3]};
+    EXPECT_EQ(overrun.pushBatch(batch,2), 2);
+    EXPECT_GE(overrun.getPushStats().slowPushes, slowPushes + 4);
+    EXPECT_EQ(overrun.pop(), &items[2]);
+    EXPECT_EQ(overrun.pop(), &items[3]);
+    EXPECT_EQ(overrun.pop(), nullptr);
+
+    Bounded empty(2);
+    std::thread producer([&](){
+        while(BoundedProbe::slowPush(empty,&items[1]) != detail::SlowPush::Helped);
+    });
+    int* taken = nullptr;
+    while(taken == nullptr)
+        taken = empty.pop();
+    producer.join();
+    EXPECT_EQ(taken, &items[1]);
+    EXPECT_EQ(empty.pop(), nullptr);
+    EXPECT_EQ(empty.getPushStats().helpedPushes, 1);
+    EXPECT_EQ(empty.getPushStats().forcedCloses, 0);
+
+    Unbounded* full = UnboundedProbe::make(2);
+    ASSERT_TRUE(full->push(&items[2]));
+    ASSERT_TRUE(full->push(&items[3]));
+    EXPECT_EQ(UnboundedProbe::slowPush(*full,&items[0]), detail::SlowPush::Closed);
+    EXPECT_EQ(full->getPushStats().slowPushes, 1);
+    EXPECT_EQ(full->getPushStats().helpedPushes, 0);
+    EXPECT_EQ(full->getPushStats().forcedCloses, 1);
+    EXPECT_FALSE(full->push(&items[1]));
+    EXPECT_EQ(full->pop(), &items[2]);
+    EXPECT_EQ(full->pop(), &items[3]);
+    EXPECT_EQ(full->pop(), nullptr);    //the item taken back is not in the closed segment
+    delete full;
+
+    //a batch on a full segment closes it without forcing, like push
+    Unbounded* fullBatch = UnboundedProbe::make(2);
+    ASSERT_TRUE(fullBatch->push(&items[2]));
+    ASSERT_TRUE(fullBatch->push(&items[3]));
+    int* batch2[1] = {&items[0]};
+    EXPECT_EQ(fullBatch->pushBatch(batch2,1), 0);
+    EXPECT_EQ(fullBatch->getPushStats().forcedCloses, 0);
+    EXPECT_FALSE(fullBatch->push(&items[1]));
+    delete fullBatch;
+}
+
+TEST(StarvingPush, CRQSegment){
+    starvingSegmentPush<CRQueue<int,true,true>,CRQueue<int,true,false>>();
+}
+
+TEST(StarvingPush, PRQSegment){
+    starvingSegmentPush<PRQueue<int,true,true>,PRQueue<int,true,false>>();
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();  // This runs all tests   